@@ -1,6 +1,9 @@
 package com.billing.unreal;
 
 import android.app.NativeActivity;
+import android.os.Handler;
+import android.os.Looper;
+import android.os.SystemClock;
 import java.lang.Thread;
 import android.util.Log;
 import java.util.Map;
@@ -10,6 +13,7 @@ import java.util.Arrays;
 import java.util.stream.Collectors;
 import java.util.Collections;
 import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicInteger;
 import com.google.common.collect.ImmutableList;
 import com.android.vending.billing.util.Base64;
 import org.json.JSONObject;
@@ -33,33 +37,130 @@ public class UnrealBillingAndroid
     
     private ConcurrentHashMap<String, ProductDetails> purchaseDetails;
     
+    // Purchases listener does not tell which product failed, only one billing flow is shown at a time
+    private volatile String launchedPurchaseProductID = "";
+    
+    // Send data to unreal as JSON strings instead of plain field arrays
+    private volatile boolean useJsonTransfer = false;
+    
     // Callbacks
     private native static void onProductsQuery(String[] ProductsJSON);
+    private native static void onProductsQueryFields(String[] ProductIDs, String[] ProductTypes, String[] Names, String[] Descriptions, String[] FormattedPrices, String[] CurrencyCodes, long[] MicrosPrices);
     private native static void onProductsPurchaseSuccessful(String PurchaseJSON, String Signature);
-    private native static void onProductsPurchaseError(String Error);
+    private native static void onProductsPurchaseSuccessfulFields(String ProductID, String PurchaseToken, String OrderID, String Signature, long PurchaseTime, int Quantity, int PurchaseState, boolean Acknowledged, String OriginalJson);
+    private native static void onProductsPurchaseError(String ProductID, String Error);
+    private native static void onPurchasesFinalized(String[] PurchaseTokens, int[] ResponseCodes);
+    private native static void onPurchasesRestored(String[] PurchasesJSON, String[] Signatures);
+    private native static void onPurchasesRestoreComplete(int ResponseCode);
+    private native static void onBillingConnectionStateChanged(int State, int ResponseCode, long ConnectMillis);
+    
+    // Connection states, same values as EBillingConnectionState
+    private static final int CONNECTION_DISCONNECTED = 0;
+    private static final int CONNECTION_CONNECTING = 1;
+    private static final int CONNECTION_CONNECTED = 2;
+    
+    // Reconnect delay doubles after every failed attempt, up to max
+    private static final long RECONNECT_BASE_DELAY_MS = 1000;
+    private static final long RECONNECT_MAX_DELAY_MS = 60000;
+    
+    // Queued operations fail after this many failed attempts in a row, reconnecting goes on
+    private static final int QUEUE_FAIL_ATTEMPTS = 3;
+    
+    // Store call that waits for connection
+    private interface BillingOperation {
+        void run();
+        void fail(int ResponseCode);
+    }
+    
+    private final Object connectionLock = new Object();
+    private int connectionState = CONNECTION_DISCONNECTED;
+    private int failedConnectAttempts = 0;
+    private long connectStartTime = 0;
+    private long lastConnectMillis = 0;
+    private boolean reconnectScheduled = false;
+    private final ArrayList<BillingOperation> pendingOperations = new ArrayList<BillingOperation>();
+    private Handler reconnectHandler;
+    
+    // Per product and per purchase logs, enable with "adb shell setprop log.tag.Billing VERBOSE" before start
+    private static final boolean VERBOSE_LOG = Log.isLoggable("Billing", Log.VERBOSE);
+    
+    // Restored purchases are sent to unreal in parts of this size
+    private static final int RESTORE_PART_SIZE = 20;
     
-    static public void queryProducts(String[] ProductsIDs){
+    static public void queryProducts(String[] ProductsIDs, boolean UseJsonTransfer, int ShardSize){
         if(unrealBilling == null) {
             Log.e("Billing", "No unreal billing initialized!");
             return;
         }
-        unrealBilling.queryProducts_Internal(ProductsIDs);
+        unrealBilling.useJsonTransfer = UseJsonTransfer;
+        unrealBilling.queryProducts_Internal(ProductsIDs, ShardSize);
     }
     
-    static public void purchase(String ProductID){
+    static public void purchase(final String ProductID, boolean UseJsonTransfer){
         if(unrealBilling == null) {
             Log.e("Billing", "No unreal billing initialized!");
             return;
         }
-        unrealBilling.purchase_Internal(ProductID);
+        unrealBilling.useJsonTransfer = UseJsonTransfer;
+        unrealBilling.runWhenConnected(new BillingOperation() {
+            public void run() {
+                unrealBilling.purchase_Internal(ProductID);
+            }
+            public void fail(int ResponseCode) {
+                onProductsPurchaseError(ProductID, "Billing is not connected, response code " + ResponseCode);
+            }
+        });
     }
     
-    static public void finalizePurchase(String PurchaseToken, boolean Consume){
+    static public void finalizePurchases(final String[] PurchaseTokens, final boolean[] Consume){
         if(unrealBilling == null) {
             Log.e("Billing", "No unreal billing initialized!");
             return;
         }
-        unrealBilling.finalizePurchase_Internal(PurchaseToken, Consume);
+        unrealBilling.runWhenConnected(new BillingOperation() {
+            public void run() {
+                unrealBilling.finalizePurchases_Internal(PurchaseTokens, Consume);
+            }
+            public void fail(int ResponseCode) {
+                if(PurchaseTokens.length == 0) return;
+                
+                int[] responseCodes = new int[PurchaseTokens.length];
+                Arrays.fill(responseCodes, ResponseCode);
+                onPurchasesFinalized(PurchaseTokens, responseCodes);
+            }
+        });
+    }
+    
+    static public void restorePurchases(){
+        if(unrealBilling == null) {
+            Log.e("Billing", "No unreal billing initialized!");
+            return;
+        }
+        unrealBilling.runWhenConnected(new BillingOperation() {
+            public void run() {
+                unrealBilling.restorePurchases_Internal();
+            }
+            public void fail(int ResponseCode) {
+                onPurchasesRestoreComplete(ResponseCode);
+            }
+        });
+    }
+    
+    static public int getConnectionState(){
+        if(unrealBilling == null) return CONNECTION_DISCONNECTED;
+        
+        synchronized(unrealBilling.connectionLock){
+            return unrealBilling.connectionState;
+        }
+    }
+    
+    // Time last successful connection took, for state read by unreal instead of reported by callback
+    static public long getLastConnectMillis(){
+        if(unrealBilling == null) return 0;
+        
+        synchronized(unrealBilling.connectionLock){
+            return unrealBilling.lastConnectMillis;
+        }
     }
    
     public void init(NativeActivity appActivity)
@@ -69,6 +170,7 @@ public class UnrealBillingAndroid
         activity = appActivity;
         
         purchaseDetails = new ConcurrentHashMap();
+        reconnectHandler = new Handler(Looper.getMainLooper());
         
         Log.d("Billing", "Billing init!");
         
@@ -79,18 +181,14 @@ public class UnrealBillingAndroid
                     
                     for(Purchase purchase : purchases)
                     {
-                        String receipt = purchase.getOriginalJson();
-                        
-                        Log.d("Billing", "Purchase successful: " + receipt);
-
-                        onProductsPurchaseSuccessful(receipt, purchase.getSignature());
+                        sendPurchase(purchase);
                     }
                 }
                 else
                 {
                     Log.d("Billing", "Purchase error: " + billingResult.getDebugMessage());
                     
-                    onProductsPurchaseError(billingResult.getDebugMessage());
+                    onProductsPurchaseError(launchedPurchaseProductID, billingResult.getDebugMessage());
                 }
             }
         };
@@ -103,37 +201,158 @@ public class UnrealBillingAndroid
         connectToBilling();
     }
     
+    // Runs operation now if connected, otherwise queues it until connection is set up
+    private void runWhenConnected(BillingOperation Operation)
+    {
+        boolean queued = false;
+        boolean connectNow = false;
+        
+        synchronized(connectionLock){
+            if(connectionState != CONNECTION_CONNECTED){
+                pendingOperations.add(Operation);
+                queued = true;
+                connectNow = connectionState == CONNECTION_DISCONNECTED && !reconnectScheduled;
+            }
+        }
+        
+        if(connectNow){
+            connectToBilling();
+        }
+        
+        if(!queued){
+            Operation.run();
+        }
+    }
+    
     private void connectToBilling()
     {
+        synchronized(connectionLock){
+            if(connectionState != CONNECTION_DISCONNECTED) return;
+            
+            connectionState = CONNECTION_CONNECTING;
+            reconnectScheduled = false;
+            connectStartTime = SystemClock.elapsedRealtime();
+        }
+        
         Log.d("Billing", "Billing Connecting..");
+        notifyConnectionState(CONNECTION_CONNECTING, BillingResponseCode.OK, 0);
         
         billingClient.startConnection(new BillingClientStateListener() {
             @Override
             public void onBillingSetupFinished(BillingResult billingResult) {
                 if (billingResult.getResponseCode() ==  BillingResponseCode.OK) {
-                   Log.d("Billing", "Billing connected!");
+                    onConnected();
+                }
+                else {
+                    onConnectionFailed(billingResult.getResponseCode());
                 }
             }
             @Override
             public void onBillingServiceDisconnected() {
-                // Try to restart the connection on the next request to
-                // Google Play by calling the startConnection() method.
                 Log.d("Billing", "Billing disconnected!");
+                onConnectionFailed(BillingResponseCode.SERVICE_DISCONNECTED);
             }
         });
     }
     
-    private void queryProducts_Internal(String[] ProductsIDs)
+    private void onConnected()
+    {
+        long connectMillis;
+        ArrayList<BillingOperation> operations;
+        
+        synchronized(connectionLock){
+            connectionState = CONNECTION_CONNECTED;
+            failedConnectAttempts = 0;
+            connectMillis = SystemClock.elapsedRealtime() - connectStartTime;
+            lastConnectMillis = connectMillis;
+            
+            operations = new ArrayList<BillingOperation>(pendingOperations);
+            pendingOperations.clear();
+        }
+        
+        Log.d("Billing", "Billing connected in " + connectMillis + " ms, queued operations: " + operations.size());
+        notifyConnectionState(CONNECTION_CONNECTED, BillingResponseCode.OK, connectMillis);
+        
+        for(BillingOperation operation : operations){
+            operation.run();
+        }
+    }
+    
+    private void onConnectionFailed(int ResponseCode)
     {
-        Log.d("Billing", "Query products...");
-        Log.d("Billing", "Query products thread:" + Thread.currentThread().getName());
+        ArrayList<BillingOperation> failedOperations = null;
+        long reconnectDelay;
+        
+        synchronized(connectionLock){
+            // Setup failure may be followed by disconnect for the same attempt
+            if(reconnectScheduled) return;
+            
+            connectionState = CONNECTION_DISCONNECTED;
+            failedConnectAttempts++;
+            
+            if(failedConnectAttempts >= QUEUE_FAIL_ATTEMPTS && !pendingOperations.isEmpty()){
+                failedOperations = new ArrayList<BillingOperation>(pendingOperations);
+                pendingOperations.clear();
+            }
+            
+            reconnectDelay = Math.min(RECONNECT_BASE_DELAY_MS << Math.min(failedConnectAttempts - 1, 16), RECONNECT_MAX_DELAY_MS);
+            reconnectScheduled = true;
+        }
+        
+        Log.d("Billing", "Billing connection lost: " + ResponseCode + ", reconnect in " + reconnectDelay + " ms");
+        notifyConnectionState(CONNECTION_DISCONNECTED, ResponseCode, 0);
+        
+        if(failedOperations != null){
+            for(BillingOperation operation : failedOperations){
+                operation.fail(ResponseCode);
+            }
+        }
+        
+        reconnectHandler.postDelayed(new Runnable() {
+            public void run() {
+                connectToBilling();
+            }
+        }, reconnectDelay);
+    }
+    
+    private void notifyConnectionState(int State, int ResponseCode, long ConnectMillis)
+    {
+        try {
+            onBillingConnectionStateChanged(State, ResponseCode, ConnectMillis); // Send to Unreal
+        } catch (UnsatisfiedLinkError e) {
+            // Unreal registers callbacks on module startup and reads current state then
+        }
+    }
+    
+    // Shards are queried in parallel and every shard is sent to unreal as soon as it is answered
+    private void queryProducts_Internal(String[] ProductsIDs, int ShardSize)
+    {
+        Log.d("Billing", "Query products: " + ProductsIDs.length);
+        if(VERBOSE_LOG) Log.v("Billing", "Query products thread:" + Thread.currentThread().getName());
         
         List<String> products = Arrays.asList(ProductsIDs);
+        int shardSize = ShardSize > 0 ? ShardSize : Math.max(products.size(), 1);
         
+        for(int shardStart = 0; shardStart < products.size(); shardStart += shardSize){
+            final List<String> shard = products.subList(shardStart, Math.min(shardStart + shardSize, products.size()));
+            runWhenConnected(new BillingOperation() {
+                public void run() {
+                    queryProductsShard(shard);
+                }
+                public void fail(int ResponseCode) {
+                    // Unanswered products are requested again by Unreal after timeout
+                    Log.e("Billing", "Query products failed, billing is not connected: " + ResponseCode);
+                }
+            });
+        }
+    }
+    
+    private void queryProductsShard(List<String> products)
+    {
         List<Product> productList = new ArrayList<Product>();
         
         for(String Id : products){
-            Log.d("Billing", "Query product: " + Id);
+            if(VERBOSE_LOG) Log.v("Billing", "Query product: " + Id);
             
             productList.add(
                 Product.newBuilder()
@@ -154,14 +373,19 @@ public class UnrealBillingAndroid
                     if (billingResult.getResponseCode() ==  BillingResponseCode.OK) {   
                         int detailsAmount = productDetailsList.size();
                         Log.d("Billing", "Query success. Amount of products:" + detailsAmount);
-                        Log.d("Billing", "Query success. Thread:" + Thread.currentThread().getName());
+                        if(VERBOSE_LOG) Log.v("Billing", "Query success. Thread:" + Thread.currentThread().getName());
+                        
+                        if(!useJsonTransfer){
+                            sendProductsFields(productDetailsList);
+                            return;
+                        }
                         
                         String[] ProductsJSON = new String[detailsAmount];
                         
                         for(int i=0; i < detailsAmount; i++){
                             ProductDetails details = productDetailsList.get(i);
                             
-                            Log.d("Billing", "Product info: " + details.toString());
+                            if(VERBOSE_LOG) Log.v("Billing", "Product info: " + details.toString());
                             
                             try {
                                 JSONObject productJSON = new JSONObject();
@@ -197,6 +421,67 @@ public class UnrealBillingAndroid
         );
     }
 
+    private void sendProductsFields(List<ProductDetails> productDetailsList)
+    {
+        int detailsAmount = productDetailsList.size();
+        
+        String[] productIDs = new String[detailsAmount];
+        String[] productTypes = new String[detailsAmount];
+        String[] names = new String[detailsAmount];
+        String[] descriptions = new String[detailsAmount];
+        String[] formattedPrices = new String[detailsAmount];
+        String[] currencyCodes = new String[detailsAmount];
+        long[] microsPrices = new long[detailsAmount];
+        
+        for(int i=0; i < detailsAmount; i++){
+            ProductDetails details = productDetailsList.get(i);
+            
+            productIDs[i] = details.getProductId();
+            productTypes[i] = details.getProductType();
+            names[i] = details.getName();
+            descriptions[i] = details.getDescription();
+            
+            OneTimePurchaseOfferDetails OneTimePurchaseDetails = details.getOneTimePurchaseOfferDetails();
+            
+            if(OneTimePurchaseDetails != null){
+                formattedPrices[i] = OneTimePurchaseDetails.getFormattedPrice();
+                currencyCodes[i] = OneTimePurchaseDetails.getPriceCurrencyCode();
+                microsPrices[i] = OneTimePurchaseDetails.getPriceAmountMicros();
+            }
+            
+            purchaseDetails.put(details.getProductId(), details);
+        }
+        
+        Log.d("Billing", "Send products fields to unreal");
+        onProductsQueryFields(productIDs, productTypes, names, descriptions, formattedPrices, currencyCodes, microsPrices);
+    }
+    
+    private void sendPurchase(Purchase purchase)
+    {
+        if(useJsonTransfer){
+            String receipt = purchase.getOriginalJson();
+            
+            if(VERBOSE_LOG) Log.v("Billing", "Purchase successful: " + receipt);
+            
+            onProductsPurchaseSuccessful(receipt, purchase.getSignature());
+            return;
+        }
+        
+        List<String> products = purchase.getProducts();
+        
+        onProductsPurchaseSuccessfulFields(
+            products.isEmpty() ? "" : products.get(0),
+            purchase.getPurchaseToken(),
+            purchase.getOrderId(),
+            purchase.getSignature(),
+            purchase.getPurchaseTime(),
+            purchase.getQuantity(),
+            purchase.getPurchaseState(),
+            purchase.isAcknowledged(),
+            purchase.getOriginalJson() // Signed data, needed for signature verification
+        );
+    }
+
     private void purchase_Internal(String ProductID)
     {
         Log.d("Billing", "Start purchase...");
@@ -206,8 +491,12 @@ public class UnrealBillingAndroid
         
         if(Details == null){
             Log.w("Billing", "No details for purchase: " + ProductID);
+            onProductsPurchaseError(ProductID, "No product details for " + ProductID);
+            return;
         }
         
+        launchedPurchaseProductID = ProductID;
+        
         ImmutableList productDetailsParamsList =
             ImmutableList.of(
                 ProductDetailsParams.newBuilder()
@@ -223,42 +512,117 @@ public class UnrealBillingAndroid
         BillingResult billingResult = billingClient.launchBillingFlow(activity, billingFlowParams);
     }
     
-    private void finalizePurchase_Internal(String PurchaseToken, boolean Consume)
+    private void finalizePurchases_Internal(final String[] PurchaseTokens, boolean[] Consume)
     {
-        Log.d("Billing", "Finalizing purchase...");
+        final int tokensAmount = PurchaseTokens.length;
         
-        if(Consume){
-            ConsumeParams consumeParams =
-                ConsumeParams.newBuilder()
-                .setPurchaseToken(PurchaseToken)
-                .build();
+        Log.d("Billing", "Finalizing purchases: " + tokensAmount);
         
-            ConsumeResponseListener listener = new ConsumeResponseListener() {
-                @Override
-                public void onConsumeResponse(BillingResult billingResult, String purchaseToken) {
-                    if (billingResult.getResponseCode() == BillingResponseCode.OK) {
-                        // TODO: Handle consume operation.
+        if(tokensAmount == 0) return;
+        
+        // Written by listeners on any thread, last finished request sends all results to unreal
+        final int[] responseCodes = new int[tokensAmount];
+        final AtomicInteger requestsLeft = new AtomicInteger(tokensAmount);
+        
+        for(int i=0; i < tokensAmount; i++){
+            final int index = i;
+            
+            if(Consume[i]){
+                ConsumeParams consumeParams =
+                    ConsumeParams.newBuilder()
+                    .setPurchaseToken(PurchaseTokens[i])
+                    .build();
+                
+                billingClient.consumeAsync(consumeParams, new ConsumeResponseListener() {
+                    @Override
+                    public void onConsumeResponse(BillingResult billingResult, String purchaseToken) {
+                        finishFinalizeRequest(PurchaseTokens, responseCodes, requestsLeft, index, billingResult);
                     }
-                }
-            };
+                });
+            }
+            else
+            {
+                AcknowledgePurchaseParams acknowledgePurchaseParams =
+                    AcknowledgePurchaseParams.newBuilder()
+                    .setPurchaseToken(PurchaseTokens[i])
+                    .build();
+                
+                billingClient.acknowledgePurchase(acknowledgePurchaseParams, new AcknowledgePurchaseResponseListener() {
+                    @Override
+                    public void onAcknowledgePurchaseResponse(BillingResult billingResult){
+                        finishFinalizeRequest(PurchaseTokens, responseCodes, requestsLeft, index, billingResult);
+                    }
+                });
+            }
+        }
+    }
+    
+    private void finishFinalizeRequest(String[] PurchaseTokens, int[] ResponseCodes, AtomicInteger RequestsLeft, int Index, BillingResult billingResult)
+    {
+        ResponseCodes[Index] = billingResult.getResponseCode();
         
-            billingClient.consumeAsync(consumeParams, listener);
+        if(billingResult.getResponseCode() != BillingResponseCode.OK) {
+            Log.d("Billing", "Finalize error: " + billingResult.getDebugMessage());
         }
-        else 
-        {
-            AcknowledgePurchaseResponseListener acknowledgePurchaseResponseListener = new AcknowledgePurchaseResponseListener() {
+        
+        if(RequestsLeft.decrementAndGet() == 0) {
+            onPurchasesFinalized(PurchaseTokens, ResponseCodes); // Send to Unreal
+        }
+    }
+    
+    private void restorePurchases_Internal()
+    {
+        Log.d("Billing", "Restore purchases...");
+        
+        // Both queries run together, each answer is sent as soon as it arrives, last one completes restore
+        final String[] productTypes = { ProductType.INAPP, ProductType.SUBS };
+        final AtomicInteger queriesLeft = new AtomicInteger(productTypes.length);
+        final AtomicInteger responseCode = new AtomicInteger(BillingResponseCode.OK);
+        
+        for(String productType : productTypes){
+            QueryPurchasesParams queryPurchasesParams = QueryPurchasesParams.newBuilder()
+                .setProductType(productType)
+                .build();
+            
+            billingClient.queryPurchasesAsync(queryPurchasesParams, new PurchasesResponseListener() {
                 @Override
-                public void onAcknowledgePurchaseResponse(BillingResult billingResult){
-                    // TODO: Handle acknowledge
+                public void onQueryPurchasesResponse(BillingResult billingResult, List<Purchase> purchases) {
+                    if(billingResult.getResponseCode() == BillingResponseCode.OK) {
+                        sendRestoredPurchases(purchases);
+                    }
+                    else {
+                        Log.d("Billing", "Restore error: " + billingResult.getDebugMessage());
+                        responseCode.compareAndSet(BillingResponseCode.OK, billingResult.getResponseCode());
+                    }
+                    
+                    if(queriesLeft.decrementAndGet() == 0) {
+                        onPurchasesRestoreComplete(responseCode.get()); // Send to Unreal
+                    }
                 }
-            };
+            });
+        }
+    }
+    
+    private void sendRestoredPurchases(List<Purchase> purchases)
+    {
+        int purchasesAmount = purchases.size();
+        
+        Log.d("Billing", "Restored purchases: " + purchasesAmount);
+        
+        for(int partStart = 0; partStart < purchasesAmount; partStart += RESTORE_PART_SIZE){
+            int partSize = Math.min(RESTORE_PART_SIZE, purchasesAmount - partStart);
             
-            AcknowledgePurchaseParams acknowledgePurchaseParams =
-                AcknowledgePurchaseParams.newBuilder()
-                .setPurchaseToken(PurchaseToken)
-                .build();
+            String[] purchasesJSON = new String[partSize];
+            String[] signatures = new String[partSize];
+            
+            for(int i=0; i < partSize; i++){
+                Purchase purchase = purchases.get(partStart + i);
+                
+                purchasesJSON[i] = purchase.getOriginalJson();
+                signatures[i] = purchase.getSignature();
+            }
             
-            billingClient.acknowledgePurchase(acknowledgePurchaseParams, acknowledgePurchaseResponseListener);
+            onPurchasesRestored(purchasesJSON, signatures); // Send to Unreal
         }
     }
 }
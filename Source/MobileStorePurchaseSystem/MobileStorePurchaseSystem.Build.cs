@@ -34,6 +34,7 @@ public class MobileStorePurchaseSystem : ModuleRules
 				"SerializationSystem",
 				"OnlineSubsystem",
 				"Json",
+				"RSA",
 				"UMG"
 			}
 		);
@@ -0,0 +1,311 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Benchmarks/MobileStorePurchaseBenchmark.h"
+
+#include "LogSystem.h"
+#include "Containers/Ticker.h"
+#include "Data/ShopItemData.h"
+#include "Data/StoreShopCustomData.h"
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Items/ShopItemMobileStorePurchase.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Proxies/PurchaseProxyInterfaceFake.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand MobileStorePurchaseBenchmarkCommand(
+	TEXT("MobileStorePurchase.Benchmark"),
+	TEXT("Runs purchase pipeline benchmark against fake store. Optional argument: purchase iterations"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		UMobileStorePurchaseBenchmark::Run(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100);
+	})
+);
+#endif
+
+namespace PurchaseBenchmark
+{
+	static TSharedPtr<FJsonObject> MakeTimingsObject(TArray<double> Seconds)
+	{
+		TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField("Samples", Seconds.Num());
+		if(Seconds.Num() <= 0) return Object;
+
+		Seconds.Sort();
+
+		double Total = 0.0;
+		for(const double Value : Seconds)
+		{
+			Total += Value;
+		}
+
+		Object->SetNumberField("MinMs", Seconds[0] * 1000.0);
+		Object->SetNumberField("AvgMs", Total / Seconds.Num() * 1000.0);
+		Object->SetNumberField("P50Ms", Seconds[Seconds.Num() / 2] * 1000.0);
+		Object->SetNumberField("P95Ms", Seconds[FMath::Min(Seconds.Num() - 1, Seconds.Num() * 95 / 100)] * 1000.0);
+		Object->SetNumberField("MaxMs", Seconds.Last() * 1000.0);
+
+		return Object;
+	}
+}
+
+UMobileStorePurchaseBenchmark* UMobileStorePurchaseBenchmark::Run(int32 PurchaseIterations)
+{
+	UMobileStorePurchaseBenchmark* Benchmark = NewObject<UMobileStorePurchaseBenchmark>(GetTransientPackage());
+	Benchmark->AddToRoot();
+	Benchmark->Start(FMath::Max(PurchaseIterations, 0));
+
+	return Benchmark;
+}
+
+void UMobileStorePurchaseBenchmark::Start(int32 InPurchaseIterations)
+{
+	bRunning = true;
+
+	Results = MakeShared<FJsonObject>();
+	Results->SetStringField("Timestamp", FDateTime::UtcNow().ToIso8601());
+	Results->SetStringField("Platform", FPlatformProperties::IniPlatformName());
+	Results->SetStringField("BuildConfiguration", LexToString(FApp::GetBuildConfiguration()));
+
+	LOG(LogMobileStorePurchaseSystem, "Purchase benchmark started")
+
+	Results->SetArrayField("CatalogIngest", {});
+	for(const int32 ProductsNum : {100, 1000, 10000})
+	{
+		RunCatalogIngest(ProductsNum);
+	}
+
+	RunLookups(10000);
+
+	// Purchases go through fake store callbacks, so they take several frames
+	PurchaseManager = NewObject<UManagerMobileStorePurchase>(this);
+	FakeStore = NewObject<UPurchaseProxyInterfaceFake>(PurchaseManager);
+	FakeStore->QueryLatency = FFakeStoreLatency(0.f, 0.f);
+	FakeStore->PurchaseLatency = FFakeStoreLatency(0.f, 0.f);
+	FakeStore->FinalizeLatency = FFakeStoreLatency(0.f, 0.f);
+	FakeStore->PurchaseErrorRate = 0.f;
+	FakeStore->DuplicateCallbackRate = 0.f;
+	FakeStore->PendingPurchaseRate = 0.f;
+
+	PurchaseManager->SetPurchaseInterface(FakeStore);
+
+	PurchaseIterations = InPurchaseIterations;
+	PurchasesLeft = PurchaseIterations;
+	ManagerPurchaseTimes.Reserve(PurchaseIterations);
+
+	StartNextManagerPurchase();
+}
+
+void UMobileStorePurchaseBenchmark::Finish()
+{
+	Results->SetObjectField("Purchase", PurchaseBenchmark::MakeTimingsObject(PurchaseTimes));
+	Results->SetObjectField("ManagerPurchase", PurchaseBenchmark::MakeTimingsObject(ManagerPurchaseTimes));
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Results.ToSharedRef(), Writer);
+
+	ResultsPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("MobileStorePurchase_%s.json"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Json, *ResultsPath);
+
+	LOG(LogMobileStorePurchaseSystem, "Purchase benchmark finished: %s", *ResultsPath)
+	LOG(LogMobileStorePurchaseSystem, "%s", *Json)
+
+	if(ShopItem)
+	{
+		ShopItem->OnStorePurchaseFinished.RemoveAll(this);
+	}
+	
+	bRunning = false;
+	RemoveFromRoot();
+}
+
+void UMobileStorePurchaseBenchmark::RunCatalogIngest(int32 ProductsNum)
+{
+	UManagerMobileStorePurchase* Manager = NewObject<UManagerMobileStorePurchase>(this);
+
+	const uint64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	
+	TArray<FStoreProduct> Products = MakeProducts(ProductsNum);
+
+	const double StartTime = FPlatformTime::Seconds();
+	Manager->ReceiveStoreProducts(Products);
+	const double IngestSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// Only manager keeps products now
+	Products.Empty();
+
+	const uint64 MemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetNumberField("Products", ProductsNum);
+	Object->SetNumberField("IngestMs", IngestSeconds * 1000.0);
+	Object->SetNumberField("IngestUsPerProduct", IngestSeconds * 1000000.0 / ProductsNum);
+	Object->SetNumberField("BytesPerOffer", MemoryAfter > MemoryBefore ? static_cast<double>(MemoryAfter - MemoryBefore) / ProductsNum : 0.0);
+	Object->SetNumberField("CatalogBytesPerProduct", static_cast<double>(Manager->GetStoreCatalog().GetAllocatedSize()) / ProductsNum);
+
+	TArray<TSharedPtr<FJsonValue>> CatalogIngest = Results->GetArrayField("CatalogIngest");
+	CatalogIngest.Add(MakeShared<FJsonValueObject>(Object));
+	Results->SetArrayField("CatalogIngest", CatalogIngest);
+
+	Manager->MarkAsGarbage();
+}
+
+void UMobileStorePurchaseBenchmark::RunLookups(int32 ProductsNum)
+{
+	constexpr int32 Rounds = 10;
+
+	UManagerMobileStorePurchase* Manager = NewObject<UManagerMobileStorePurchase>(this);
+	UShopItemData* ShopItemData = NewObject<UShopItemData>(Manager);
+
+	const TArray<FStoreProduct> Products = MakeProducts(ProductsNum);
+	Manager->ReceiveStoreProducts(Products);
+
+	TArray<FString> ProductIDs;
+	ProductIDs.Reserve(ProductsNum);
+	
+	for(const FStoreProduct& Product : Products)
+	{
+		ProductIDs.Add(Product.ProductID);
+		Manager->AddProductToIndex(Product.ProductID, ShopItemData, true);
+	}
+
+	int32 Found = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for(int32 Round = 0; Round < Rounds; ++Round)
+	{
+		for(const FString& ProductID : ProductIDs)
+		{
+			// Price read is what bulk consumers do, offer views are for displayed products only
+			const int32 Handle = Manager->GetStoreCatalog().FindHandle(ProductID);
+			Found += Handle != INDEX_NONE && Manager->GetStoreCatalog().GetMicrosPrice(Handle) > 0 ? 1 : 0;
+		}
+	}
+	const double CatalogLookupSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 Round = 0; Round < Rounds; ++Round)
+	{
+		for(const FString& ProductID : ProductIDs)
+		{
+			Found += Manager->FindShopItemByProductId(ProductID) ? 1 : 0;
+		}
+	}
+	const double FindShopItemSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const int32 Lookups = ProductsNum * Rounds;
+
+	TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetNumberField("Products", ProductsNum);
+	Object->SetNumberField("Lookups", Lookups);
+	Object->SetNumberField("Found", Found);
+	Object->SetNumberField("CatalogLookupNs", CatalogLookupSeconds * 1000000000.0 / Lookups);
+	Object->SetNumberField("FindShopItemByProductIdNs", FindShopItemSeconds * 1000000000.0 / Lookups);
+
+	Results->SetObjectField("Lookups", Object);
+
+	Manager->MarkAsGarbage();
+}
+
+void UMobileStorePurchaseBenchmark::StartNextManagerPurchase()
+{
+	if(PurchasesLeft <= 0)
+	{
+		StartShopItemPurchases();
+		return;
+	}
+
+	PurchasesLeft--;
+	PurchaseStartTime = FPlatformTime::Seconds();
+
+	PurchaseManager->StartPurchase(FakeStore->GetGeneratedProductID(PurchasesLeft % FMath::Max(FakeStore->CatalogSize, 1)), true,
+		FPurchaseCompleteDelegate::CreateUObject(this, &UMobileStorePurchaseBenchmark::OnManagerPurchaseComplete)
+	);
+}
+
+void UMobileStorePurchaseBenchmark::OnManagerPurchaseComplete(bool Success, FPurchaseReceiptInfo Receipt)
+{
+	ManagerPurchaseTimes.Add(FPlatformTime::Seconds() - PurchaseStartTime);
+
+	if(Success)
+	{
+		PurchaseManager->MarkPurchaseGranted(Receipt.TransactionID);
+		PurchaseManager->FinalizePurchase(Receipt);
+	}
+
+	StartNextManagerPurchase();
+}
+
+void UMobileStorePurchaseBenchmark::StartShopItemPurchases()
+{
+	// Same path as purchase button: widget, deferred store flow, grant and finalize by item
+	UShopItemData* ShopItemData = NewObject<UShopItemData>(this);
+	UStoreShopCustomData* StoreShopCustomData = NewObject<UStoreShopCustomData>(ShopItemData);
+	StoreShopCustomData->ProductID = FakeStore->GetGeneratedProductID(0);
+	StoreShopCustomData->bIsConsumable = true;
+	ShopItemData->CustomData.Add(StoreShopCustomData);
+
+	ShopItem = NewObject<UShopItemMobileStorePurchase>(this);
+	ShopItem->InitStandalone(ShopItemData, PurchaseManager);
+	ShopItem->OnStorePurchaseFinished.AddUObject(this, &UMobileStorePurchaseBenchmark::OnShopItemPurchaseFinished);
+
+	PurchasesLeft = PurchaseIterations;
+	PurchaseTimes.Reserve(PurchaseIterations);
+
+	StartNextShopItemPurchase();
+}
+
+void UMobileStorePurchaseBenchmark::StartNextShopItemPurchase()
+{
+	if(PurchasesLeft <= 0)
+	{
+		Finish();
+		return;
+	}
+
+	PurchasesLeft--;
+	PurchaseStartTime = FPlatformTime::Seconds();
+
+	if(!ShopItem->Buy())
+	{
+		LOG(LogMobileStorePurchaseSystem, "Purchase benchmark shop item refused to buy, purchases left: %i", PurchasesLeft)
+		Finish();
+	}
+}
+
+void UMobileStorePurchaseBenchmark::OnShopItemPurchaseFinished(bool Success)
+{
+	PurchaseTimes.Add(FPlatformTime::Seconds() - PurchaseStartTime);
+
+	// Item grants and finalizes right after it finished, next Buy waits a tick for that
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float)
+	{
+		StartNextShopItemPurchase();
+		return false;
+	}));
+}
+
+TArray<FStoreProduct> UMobileStorePurchaseBenchmark::MakeProducts(int32 ProductsNum)
+{
+	TArray<FStoreProduct> Products;
+	Products.Reserve(ProductsNum);
+
+	for(int32 i = 0; i < ProductsNum; ++i)
+	{
+		FStoreProduct& Product = Products.AddDefaulted_GetRef();
+		Product.ProductID = FString::Printf(TEXT("benchmark_product_%i"), i);
+		Product.Title = Product.ProductID;
+		Product.Description = TEXT("Benchmark product description");
+		Product.PriceText = TEXT("$0.99");
+		Product.MicrosPrice = 990000;
+		Product.CurrencyCode = TEXT("USD");
+	}
+
+	return Products;
+}
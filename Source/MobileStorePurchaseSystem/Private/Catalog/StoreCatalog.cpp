@@ -0,0 +1,164 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Catalog/StoreCatalog.h"
+
+FStoreProduct FStoreProduct::FromOffer(const FOnlineStoreOffer& Offer)
+{
+	FStoreProduct Product;
+	Product.ProductID = Offer.OfferId;
+	Product.Title = Offer.Title.ToString();
+	Product.Description = Offer.Description.ToString();
+	Product.PriceText = Offer.PriceText.ToString();
+	Product.CurrencyCode = Offer.CurrencyCode;
+	Product.MicrosPrice = Offer.NumericPrice;
+
+	return Product;
+}
+
+int32 FStoreCatalog::Add(const FStoreProduct& Product, bool bFresh)
+{
+	FSetElementId Id = ProductIDs.FindId(Product.ProductID);
+	if(!Id.IsValidId())
+	{
+		Id = ProductIDs.Add(Product.ProductID);
+
+		Titles.AddDefaulted();
+		Descriptions.AddDefaulted();
+		PriceTexts.AddDefaulted();
+		MicrosPrices.Add(0);
+		CurrencyIndices.Add(0);
+		FreshFlags.Add(false);
+
+		check(Id.AsInteger() == MicrosPrices.Num() - 1);
+	}
+
+	const int32 Handle = Id.AsInteger();
+
+	Titles[Handle] = Product.Title;
+	Descriptions[Handle] = Product.Description;
+	PriceTexts[Handle] = Product.PriceText;
+	MicrosPrices[Handle] = Product.MicrosPrice;
+	CurrencyIndices[Handle] = InternCurrency(Product.CurrencyCode);
+	FreshFlags[Handle] = FreshFlags[Handle] || bFresh;
+
+	// Holders of old view keep it, next request gets new data
+	OfferViews.Remove(Handle);
+
+	return Handle;
+}
+
+int32 FStoreCatalog::FindHandle(const FString& ProductID) const
+{
+	const FSetElementId Id = ProductIDs.FindId(ProductID);
+	return Id.IsValidId() ? Id.AsInteger() : INDEX_NONE;
+}
+
+bool FStoreCatalog::IsFresh(const FString& ProductID) const
+{
+	const int32 Handle = FindHandle(ProductID);
+	return Handle != INDEX_NONE && FreshFlags[Handle];
+}
+
+void FStoreCatalog::Reserve(int32 Number)
+{
+	ProductIDs.Reserve(Number);
+	Titles.Reserve(Number);
+	Descriptions.Reserve(Number);
+	PriceTexts.Reserve(Number);
+	MicrosPrices.Reserve(Number);
+	CurrencyIndices.Reserve(Number);
+	FreshFlags.Reserve(Number);
+}
+
+void FStoreCatalog::Reset()
+{
+	ProductIDs.Empty();
+	Titles.Empty();
+	Descriptions.Empty();
+	PriceTexts.Empty();
+	MicrosPrices.Empty();
+	CurrencyIndices.Empty();
+	FreshFlags.Empty();
+	Currencies.Empty();
+	OfferViews.Empty();
+}
+
+const FString& FStoreCatalog::GetProductID(int32 Handle) const
+{
+	return ProductIDs[FSetElementId::FromInteger(Handle)];
+}
+
+FStoreProduct FStoreCatalog::GetProduct(int32 Handle) const
+{
+	FStoreProduct Product;
+	Product.ProductID = GetProductID(Handle);
+	Product.Title = Titles[Handle];
+	Product.Description = Descriptions[Handle];
+	Product.PriceText = PriceTexts[Handle];
+	Product.CurrencyCode = GetCurrencyCode(Handle);
+	Product.MicrosPrice = MicrosPrices[Handle];
+
+	return Product;
+}
+
+TSharedPtr<FOnlineStoreOffer> FStoreCatalog::GetOffer(int32 Handle) const
+{
+	if(!IsValidHandle(Handle)) return nullptr;
+
+	if(const TSharedPtr<FOnlineStoreOffer>* View = OfferViews.Find(Handle))
+	{
+		return *View;
+	}
+
+	TSharedPtr<FOnlineStoreOffer> Offer = MakeShared<FOnlineStoreOffer>();
+	Offer->OfferId = GetProductID(Handle);
+	Offer->Title = FText::FromString(Titles[Handle]);
+	Offer->Description = FText::FromString(Descriptions[Handle]);
+	Offer->PriceText = FText::FromString(PriceTexts[Handle]);
+	Offer->RegularPriceText = Offer->PriceText;
+	Offer->NumericPrice = MicrosPrices[Handle];
+	Offer->RegularPrice = MicrosPrices[Handle];
+	Offer->CurrencyCode = GetCurrencyCode(Handle);
+
+	OfferViews.Add(Handle, Offer);
+
+	return Offer;
+}
+
+SIZE_T FStoreCatalog::GetAllocatedSize() const
+{
+	SIZE_T Size = ProductIDs.GetAllocatedSize()
+		+ Titles.GetAllocatedSize()
+		+ Descriptions.GetAllocatedSize()
+		+ PriceTexts.GetAllocatedSize()
+		+ MicrosPrices.GetAllocatedSize()
+		+ CurrencyIndices.GetAllocatedSize()
+		+ FreshFlags.GetAllocatedSize()
+		+ Currencies.GetAllocatedSize()
+		+ OfferViews.GetAllocatedSize()
+		+ OfferViews.Num() * sizeof(FOnlineStoreOffer);
+
+	for(const FString& ProductID : ProductIDs)
+	{
+		Size += ProductID.GetAllocatedSize();
+	}
+
+	for(int32 Handle = 0; Handle < Num(); ++Handle)
+	{
+		Size += Titles[Handle].GetAllocatedSize() + Descriptions[Handle].GetAllocatedSize() + PriceTexts[Handle].GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+uint16 FStoreCatalog::InternCurrency(const FString& CurrencyCode)
+{
+	int32 Index = Currencies.Find(CurrencyCode);
+	if(Index == INDEX_NONE)
+	{
+		check(Currencies.Num() < MAX_uint16);
+		Index = Currencies.Add(CurrencyCode);
+	}
+
+	return static_cast<uint16>(Index);
+}
@@ -0,0 +1,118 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Catalog/StoreCatalogCache.h"
+
+#include "HAL/FileManager.h"
+#include "Internationalization/Culture.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tasks/Pipe.h"
+
+// Keeps file writes in save order, last saved catalog is the one on disk
+static UE::Tasks::FPipe& GetCatalogCacheWritePipe()
+{
+	static UE::Tasks::FPipe WritePipe(TEXT("StoreCatalogCacheWrite"));
+	return WritePipe;
+}
+
+FString FStoreCatalogCache::GetCatalogKey()
+{
+	return FString::Printf(TEXT("%s_%s"),
+		*FString(FPlatformProperties::IniPlatformName()),
+		*FInternationalization::Get().GetCurrentCulture()->GetName()
+	);
+}
+
+FString FStoreCatalogCache::GetCachePath(const FString& CatalogKey)
+{
+	return FPaths::ProjectSavedDir() / TEXT("MobileStorePurchase") / FString::Printf(TEXT("Catalog_%s.bin"), *FPaths::MakeValidFileName(CatalogKey, '_'));
+}
+
+bool FStoreCatalogCache::Load(const FString& CatalogKey, FTimespan TimeToLive, TArray<FStoreProduct>& OutProducts)
+{
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *GetCachePath(CatalogKey), FILEREAD_Silent)) return false;
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int64 Timestamp = 0;
+	FString Key;
+	int32 Num = 0;
+
+	Reader << Magic << Version;
+	if(Reader.IsError() || Magic != FileMagic || Version != FileVersion) return false;
+
+	Reader << Timestamp << Key << Num;
+	if(Reader.IsError() || Key != CatalogKey) return false;
+
+	if(FDateTime::UtcNow() - FDateTime(Timestamp) > TimeToLive) return false;
+
+	// Every product takes more than one byte, anything bigger is corrupted
+	if(Num < 0 || Num > Data.Num()) return false;
+
+	// Currency table first, products reference it by index
+	TArray<FString> Currencies;
+	Reader << Currencies;
+	if(Reader.IsError()) return false;
+
+	TArray<FStoreProduct> Products;
+	Products.SetNum(Num);
+
+	for(FStoreProduct& Product : Products)
+	{
+		uint16 CurrencyIndex = 0;
+
+		Reader << Product.ProductID << Product.Title << Product.Description << Product.PriceText << CurrencyIndex << Product.MicrosPrice;
+		if(Reader.IsError() || !Currencies.IsValidIndex(CurrencyIndex)) return false;
+
+		Product.CurrencyCode = Currencies[CurrencyIndex];
+	}
+
+	OutProducts = MoveTemp(Products);
+
+	return true;
+}
+
+void FStoreCatalogCache::Save(const FString& CatalogKey, const FStoreCatalog& Catalog)
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	int64 Timestamp = FDateTime::UtcNow().GetTicks();
+	FString Key = CatalogKey;
+	int32 Num = Catalog.Num();
+
+	TArray<FString> Currencies;
+	TArray<uint16> CurrencyIndices;
+	CurrencyIndices.Reserve(Num);
+
+	for(int32 Handle = 0; Handle < Num; ++Handle)
+	{
+		CurrencyIndices.Add(static_cast<uint16>(Currencies.AddUnique(Catalog.GetCurrencyCode(Handle))));
+	}
+
+	Writer << Magic << Version << Timestamp << Key << Num << Currencies;
+
+	for(int32 Handle = 0; Handle < Num; ++Handle)
+	{
+		FStoreProduct Product = Catalog.GetProduct(Handle);
+
+		Writer << Product.ProductID << Product.Title << Product.Description << Product.PriceText << CurrencyIndices[Handle] << Product.MicrosPrice;
+	}
+
+	GetCatalogCacheWritePipe().Launch(TEXT("SaveCache"), [Data = MoveTemp(Data), Path = GetCachePath(CatalogKey)]()
+	{
+		// Write next to target and move, so crash during write keeps previous cache
+		const FString TempPath = Path + TEXT(".tmp");
+		if(FFileHelper::SaveArrayToFile(Data, *TempPath))
+		{
+			IFileManager::Get().Move(*Path, *TempPath, true, true);
+		}
+	});
+}
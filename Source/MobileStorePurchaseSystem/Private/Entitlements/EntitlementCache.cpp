@@ -0,0 +1,100 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Entitlements/EntitlementCache.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tasks/Pipe.h"
+
+// Saves are written in call order, quick grants can not land on disk reversed
+static UE::Tasks::FPipe& GetEntitlementWritePipe()
+{
+	static UE::Tasks::FPipe WritePipe(TEXT("EntitlementCacheWrite"));
+	return WritePipe;
+}
+
+FString FEntitlementCache::GetCachePath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("MobileStorePurchase") / FString::Printf(TEXT("Entitlements_%s.bin"), *FString(FPlatformProperties::IniPlatformName()));
+}
+
+void FEntitlementCache::Load()
+{
+	OwnedProducts.Reset();
+	LastReconcileTime = 0;
+	
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *GetCachePath(), FILEREAD_Silent)) return;
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int64 ReconcileTime = 0;
+	TMap<FString, FString> Products;
+
+	Reader << Magic << Version;
+	if(Reader.IsError() || Magic != FileMagic || Version != FileVersion) return;
+
+	Reader << ReconcileTime << Products;
+	if(Reader.IsError()) return;
+
+	OwnedProducts = MoveTemp(Products);
+	LastReconcileTime = ReconcileTime;
+}
+
+void FEntitlementCache::Save() const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	int64 ReconcileTime = LastReconcileTime;
+	TMap<FString, FString> Products = OwnedProducts;
+
+	Writer << Magic << Version << ReconcileTime << Products;
+
+	GetEntitlementWritePipe().Launch(TEXT("SaveCache"), [Data = MoveTemp(Data), Path = GetCachePath()]()
+	{
+		// Write next to target and move, so crash during write keeps previous cache
+		const FString TempPath = Path + TEXT(".tmp");
+		if(FFileHelper::SaveArrayToFile(Data, *TempPath))
+		{
+			IFileManager::Get().Move(*Path, *TempPath, true, true);
+		}
+	});
+}
+
+bool FEntitlementCache::Grant(const FString& ProductID, const FString& TransactionID)
+{
+	if(ProductID.IsEmpty()) return false;
+
+	const FString* OwnedTransactionID = OwnedProducts.Find(ProductID);
+	if(OwnedTransactionID && *OwnedTransactionID == TransactionID) return false;
+
+	OwnedProducts.Add(ProductID, TransactionID);
+
+	return true;
+}
+
+bool FEntitlementCache::Reconcile(const TMap<FString, FString>& StoreOwnedProducts)
+{
+	LastReconcileTime = FDateTime::UtcNow().GetTicks();
+
+	const bool bChanged = !OwnedProducts.OrderIndependentCompareEqual(StoreOwnedProducts);
+	if(bChanged)
+	{
+		OwnedProducts = StoreOwnedProducts;
+	}
+
+	return bChanged;
+}
+
+bool FEntitlementCache::IsStale(FTimespan ReconcileInterval) const
+{
+	return LastReconcileTime <= 0 || FDateTime::UtcNow() - FDateTime(LastReconcileTime) > ReconcileInterval;
+}
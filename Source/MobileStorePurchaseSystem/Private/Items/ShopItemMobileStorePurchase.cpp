@@ -7,7 +7,6 @@
 #include "Blueprint/UserWidget.h"
 #include "Data/StoreShopCustomData.h"
 #include "Data/ShopItemData.h"
-#include "Kismet/GameplayStatics.h"
 #include "Managers/ShopManager.h"
 #include "Module/MobileStorePurchaseSystemModule.h"
 #include "Module/MobileStorePurchaseSystemSettings.h"
@@ -29,19 +28,7 @@ void UShopItemMobileStorePurchase::Init_Implementation()
 	
 	if(GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
 	{
-		CheckProduct();
-
-		if (!StoreOfferInfo)
-		{
-			ManagerMobileStorePurchase->OnProductsReceived.AddUObject(this, &UShopItemMobileStorePurchase::CheckProduct);
-			
-			DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
-				LogMobileStorePurchaseSystem,
-				"Waiting %s Store Product For %s Shop Item",
-				*GetProductID(),
-				*GetName()
-			)
-		}
+		InitWithManager(ManagerMobileStorePurchase);
 	}
 	else
 	{
@@ -49,15 +36,69 @@ void UShopItemMobileStorePurchase::Init_Implementation()
 	}
 }
 
+void UShopItemMobileStorePurchase::InitStandalone(UShopItemData* Data, UManagerMobileStorePurchase* Manager)
+{
+	ShopData = Data;
+
+	if(!Manager || !GetShopData<UShopItemData>() || !GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>()) return;
+
+	InitWithManager(Manager);
+}
+
+void UShopItemMobileStorePurchase::InitWithManager(UManagerMobileStorePurchase* ManagerMobileStorePurchase)
+{
+	// Data may be loaded after manager built its index
+	ManagerMobileStorePurchase->AddShopItemDataToIndex(GetShopData<UShopItemData>());
+
+	// Purchases of this product restored without request are granted through this item
+	ManagerMobileStorePurchase->RegisterShopItem(this);
+	SubscribedManager = ManagerMobileStorePurchase;
+	
+	CheckProduct();
+
+	if(GetDefault<UMobileStorePurchaseSystemSettings>()->bPrewarmPurchaseWidget)
+	{
+		ManagerMobileStorePurchase->PrewarmPurchaseWidget(this);
+	}
+
+	// Cached store info is shown right away, but we still wait for fresh one
+	if (!bStoreInfoFresh && !ProductSubscriptionHandle.IsValid())
+	{
+		ProductSubscriptionHandle = ManagerMobileStorePurchase->SubscribeToProduct(GetProductID(),
+			FShopProductUpdateDelegate::CreateUObject(this, &UShopItemMobileStorePurchase::OnProductUpdated)
+		);
+		SubscribedProductID = GetProductID();
+		
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Waiting %s Store Product For %s Shop Item",
+			*GetProductID(),
+			*GetName()
+		)
+
+		// Constructed items go ahead of prefetch
+		ManagerMobileStorePurchase->RequestProductId(GetProductID(), EProductRequestPriority::Visible);
+	}
+}
+
 bool UShopItemMobileStorePurchase::Buy_Implementation()
 {
 	if(GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
 	{
-		OpenPurchaseWidget();
+		if(PurchaseStartHandle.IsValid()) return false;
 
-		FTimerHandle PurchaseTimer;
+		BuyStartTime = FPlatformTime::Seconds();
+		
+		OpenPurchaseWidget();
 
-		GetWorld()->GetTimerManager().SetTimer(PurchaseTimer, this, &UShopItemMobileStorePurchase::StartRealBuyProcess, 1.f);
+		// Widget gets one frame to be drawn, store flow covers it right after
+		PurchaseStartHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float)
+		{
+			PurchaseStartHandle.Reset();
+			StartRealBuyProcess();
+			
+			return false;
+		}));
 
 		return true;
 	}
@@ -65,6 +106,44 @@ bool UShopItemMobileStorePurchase::Buy_Implementation()
 	return Super::Buy_Implementation();
 }
 
+void UShopItemMobileStorePurchase::BeginDestroy()
+{
+	if(PurchaseStartHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PurchaseStartHandle);
+		PurchaseStartHandle.Reset();
+	}
+
+	if(PurchaseWidgetCloseHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PurchaseWidgetCloseHandle);
+		PurchaseWidgetCloseHandle.Reset();
+	}
+	
+	if(UManagerMobileStorePurchase* ManagerMobileStorePurchase = SubscribedManager.Get())
+	{
+		// Shared widget stays shown until every item that shows it released it
+		if(PurchaseWidget)
+		{
+			PurchaseWidget = nullptr;
+			ManagerMobileStorePurchase->HidePurchaseWidget();
+		}
+		
+		ManagerMobileStorePurchase->UnregisterShopItem(this);
+
+		// Item is gone before store answered, its request is not urgent anymore
+		if(ProductSubscriptionHandle.IsValid())
+		{
+			ManagerMobileStorePurchase->UnsubscribeFromProduct(SubscribedProductID, ProductSubscriptionHandle);
+			ManagerMobileStorePurchase->CancelProductRequest(SubscribedProductID);
+		}
+	}
+
+	ProductSubscriptionHandle.Reset();
+
+	Super::BeginDestroy();
+}
+
 void UShopItemMobileStorePurchase::Finish_Implementation()
 {
 	if(GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
@@ -79,12 +158,8 @@ int UShopItemMobileStorePurchase::GetPrice_Implementation() const
 {
 	if (GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
 	{
-#if PLATFORM_ANDROID
-		// We divide price by 100 because it include cents
-		return bStoreInfoRecieved ? StoreOfferInfo->NumericPrice/1000000 : 0;
-#else
-		return bStoreInfoRecieved ? StoreOfferInfo->NumericPrice : 0;
-#endif
+		// All stores deliver price in micros of currency unit
+		return bStoreInfoRecieved ? StoreOfferInfo->NumericPrice / 1000000 : 0;
 	}
 	else
 	{
@@ -96,7 +171,7 @@ bool UShopItemMobileStorePurchase::CanBeBought_Implementation() const
 {
 	if(GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
 	{
-		if(FinalizeTimer.IsValid()) return false;
+		if(FinalizeTimer.IsValid() || bPurchasePending) return false;
 
 		if (GetShopData<UShopItemData>() && GetShopData<UShopItemData>()->GetCustomData<UStoreShopCustomData>())
 		{
@@ -115,10 +190,15 @@ bool UShopItemMobileStorePurchase::IsStoreInfoReady() const
 {
 #if PLATFORM_ANDROID || PLATFORM_IOS
 
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	const bool bStoreInfoValid = Settings->bUseProductCatalogCache && Settings->bRequireFreshProductsForPurchase ?
+		bStoreInfoFresh :
+		bStoreInfoRecieved;
+
 #if UE_BUILD_SHIPPING
-	return bStoreInfoRecieved;
+	return bStoreInfoValid;
 #else
-	return GetDefault<UMobileStorePurchaseSystemSettings>()->bFakeInAppPurchasesInDevBuild || bStoreInfoRecieved;
+	return Settings->bFakeInAppPurchasesInDevBuild || bStoreInfoValid;
 #endif
 	
 #else
@@ -128,6 +208,9 @@ bool UShopItemMobileStorePurchase::IsStoreInfoReady() const
 
 UManagerMobileStorePurchase* UShopItemMobileStorePurchase::GetMobileStorePurchaseManager() const
 {
+	// Manager item is registered in, standalone items have no managers system
+	if(SubscribedManager.IsValid()) return SubscribedManager.Get();
+	
 	if(!GetManagersSystem()) return nullptr;
 
 	return GetManagersSystem()->GetManager<UManagerMobileStorePurchase>();
@@ -154,34 +237,68 @@ void UShopItemMobileStorePurchase::ProcessPurchaseComplete(bool Success, FPurcha
 		*Reciept.ProductID
 	);
 
+	bPurchasePending = false;
+
 	if(!GetMobileStorePurchaseManager()) return;
 	
-	GetMobileStorePurchaseManager()->OnPurchaseComplete.RemoveDynamic(this, &UShopItemMobileStorePurchase::ProcessPurchaseComplete);
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Finish SKU: %s",
+		*ShopData->Tag.ToString()
+	);
+
+	// Content is applied first, store is finalized only after grant is in purchase journal
+	FinishStorePurchase(Success);
 	
 	if(Success)
 	{
-		// TODO: Move platform finalizing after applying sku content
+		GetMobileStorePurchaseManager()->MarkPurchaseGranted(Reciept.TransactionID);
 		GetMobileStorePurchaseManager()->FinalizePurchase(Reciept);
 	}
-	
+}
+
+void UShopItemMobileStorePurchase::ProcessPurchasePending(FPurchaseReceiptInfo Reciept)
+{
 	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
 		LogMobileStorePurchaseSystem,
-		"Finish SKU: %s",
-		*ShopData->Tag.ToString()
+		"Purchase pending: %s",
+		*Reciept.ProductID
 	);
 
+	// Payment may take days, game is not locked meanwhile. Nothing is granted until purchase completes
+	bPurchasePending = true;
+	ClosePurchaseWidget();
+}
+
+void UShopItemMobileStorePurchase::GrantRecoveredPurchase(const FPurchaseReceiptInfo& Reciept)
+{
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Recovered purchase: %s",
+		*Reciept.TransactionID
+	);
+
+	ProcessPurchaseComplete(true, Reciept);
+}
+
+void UShopItemMobileStorePurchase::FinishStorePurchase(bool Success)
+{
 	FinishPurchase(Success);
+
+	OnStorePurchaseFinished.Broadcast(Success);
 }
 
 void UShopItemMobileStorePurchase::CheckProduct()
 {
-	if (!GetMobileStorePurchaseManager() || bStoreInfoRecieved) return;
+	if (!GetMobileStorePurchaseManager() || bStoreInfoFresh) return;
 
-	StoreOfferInfo = GetMobileStorePurchaseManager()->GetProduct(GetProductID());
+	TSharedPtr<FOnlineStoreOffer> Offer = GetMobileStorePurchaseManager()->GetProduct(GetProductID());
 	
-	if (StoreOfferInfo.IsValid())
+	if (Offer.IsValid())
 	{
+		StoreOfferInfo = Offer;
 		bStoreInfoRecieved = true;
+		bStoreInfoFresh = GetMobileStorePurchaseManager()->IsProductFresh(GetProductID());
 
 		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
 			LogMobileStorePurchaseSystem,
@@ -202,20 +319,66 @@ void UShopItemMobileStorePurchase::CheckProduct()
 	
 }
 
+void UShopItemMobileStorePurchase::OnProductUpdated(const FString& ProductID)
+{
+	CheckProduct();
+
+	if (bStoreInfoFresh && GetMobileStorePurchaseManager())
+	{
+		GetMobileStorePurchaseManager()->UnsubscribeFromProduct(ProductID, ProductSubscriptionHandle);
+		ProductSubscriptionHandle.Reset();
+	}
+}
+
 void UShopItemMobileStorePurchase::OpenPurchaseWidget()
 {
-	PurchaseWidget = CreateWidget<UPurchaseWidget>(UGameplayStatics::GetPlayerController(this, 0),
-		GetDefault<UMobileStorePurchaseSystemSettings>()->PurchaseWidgetClass
-	);
+	PurchaseWidgetOpenTime = FPlatformTime::Seconds();
 	
-	PurchaseWidget->Show();
+	// Still shown by this item, only cancel delayed close
+	if(PurchaseWidgetCloseHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PurchaseWidgetCloseHandle);
+		PurchaseWidgetCloseHandle.Reset();
+
+		return;
+	}
+
+	if(PurchaseWidget || !GetMobileStorePurchaseManager()) return;
+	
+	PurchaseWidget = GetMobileStorePurchaseManager()->ShowPurchaseWidget(this);
 }
 
 void UShopItemMobileStorePurchase::ClosePurchaseWidget()
 {
-	if(PurchaseWidget)
+	if(!PurchaseWidget || PurchaseWidgetCloseHandle.IsValid()) return;
+
+	const double LockTimeLeft = GetDefault<UMobileStorePurchaseSystemSettings>()->MinPurchaseLockDuration - (FPlatformTime::Seconds() - PurchaseWidgetOpenTime);
+	if(LockTimeLeft > 0.0)
+	{
+		PurchaseWidgetCloseHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this](float)
+		{
+			PurchaseWidgetCloseHandle.Reset();
+			ReleasePurchaseWidget();
+			
+			return false;
+		}), LockTimeLeft);
+
+		return;
+	}
+	
+	ReleasePurchaseWidget();
+}
+
+void UShopItemMobileStorePurchase::ReleasePurchaseWidget()
+{
+	if(!PurchaseWidget) return;
+	
+	PurchaseWidget = nullptr;
+
+	// Widget is shared, manager hides it when last item releases it
+	if(GetMobileStorePurchaseManager())
 	{
-		PurchaseWidget->Hide();
+		GetMobileStorePurchaseManager()->HidePurchaseWidget();
 	}
 }
 
@@ -231,14 +394,19 @@ void UShopItemMobileStorePurchase::StartRealBuyProcess()
 			)
 	
 	#if WITH_EDITOR
-			FinishPurchase(true);
-	#else
-	#if UE_BUILD_DEVELOPMENT
+			// Editor runs real flow only when some proxy, like fake store, is configured for this platform
+			if(!GetMobileStorePurchaseManager() || !GetMobileStorePurchaseManager()->GetPurchaseInterface())
+			{
+				FinishStorePurchase(true);
+				
+				return;
+			}
+	#elif UE_BUILD_DEVELOPMENT
 			if(const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>())
 			{
 				if(Settings->bFakeInAppPurchasesInDevBuild)
 				{
-					FinishPurchase(true);
+					FinishStorePurchase(true);
 					
 					return;
 				}
@@ -246,14 +414,17 @@ void UShopItemMobileStorePurchase::StartRealBuyProcess()
 	#endif
 			if(IsStoreInfoReady())
 			{
-				GetMobileStorePurchaseManager()->OnPurchaseComplete.AddDynamic(this, &UShopItemMobileStorePurchase::ProcessPurchaseComplete);
-				GetMobileStorePurchaseManager()->StartPurchase(GetProductID(), StoreShopCustomData->bIsConsumable);
+				GetMobileStorePurchaseManager()->StartPurchase(GetProductID(), StoreShopCustomData->bIsConsumable,
+					FPurchaseCompleteDelegate::CreateUObject(this, &UShopItemMobileStorePurchase::ProcessPurchaseComplete),
+					FPurchasePendingDelegate::CreateUObject(this, &UShopItemMobileStorePurchase::ProcessPurchasePending)
+				);
+
+				GetMobileStorePurchaseManager()->ReportPurchaseStartLatency(FPlatformTime::Seconds() - BuyStartTime);
 			}
 			else
 			{
-				FinishPurchase(false);
+				FinishStorePurchase(false);
 			}
-	#endif
 		}
 		else
 		{
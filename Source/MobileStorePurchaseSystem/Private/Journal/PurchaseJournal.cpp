@@ -0,0 +1,232 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Journal/PurchaseJournal.h"
+
+#include "LogSystem.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FPurchaseJournal::FPurchaseJournal(const FString& InPath) : Path(InPath)
+{
+}
+
+FPurchaseJournal::~FPurchaseJournal()
+{
+}
+
+FString FPurchaseJournal::GetJournalPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("MobileStorePurchase") / TEXT("PurchaseJournal.bin");
+}
+
+void FPurchaseJournal::WriteHeader(FArchive& Ar)
+{
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+
+	Ar << Magic << Version;
+}
+
+void FPurchaseJournal::WriteRecord(FArchive& Ar, EPurchaseJournalRecord Type, const FPurchaseInfoRaw& PurchaseInfo)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+
+	uint8 RecordType = static_cast<uint8>(Type);
+	FString TransactionID = PurchaseInfo.TransactionID;
+	PayloadWriter << RecordType << TransactionID;
+
+	if(Type == EPurchaseJournalRecord::Recorded)
+	{
+		FString ProductID = PurchaseInfo.ProductID;
+		TMap<FString, FString> CustomData = PurchaseInfo.CustomData;
+		PayloadWriter << ProductID << CustomData;
+	}
+
+	// Size and crc let reader detect record torn by crash
+	uint32 Size = Payload.Num();
+	uint32 Crc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+
+	Ar << Size << Crc;
+	Ar.Serialize(Payload.GetData(), Payload.Num());
+}
+
+bool FPurchaseJournal::Load()
+{
+	Entries.Reset();
+	RecordsNum = 0;
+
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent)) return true;
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if(Reader.IsError() || Magic != FileMagic || Version != FileVersion) return false;
+
+	while(Reader.Tell() + 2 * sizeof(uint32) <= Data.Num())
+	{
+		uint32 Size = 0;
+		uint32 Crc = 0;
+		Reader << Size << Crc;
+
+		const int64 RecordOffset = Reader.Tell();
+		if(Size > Data.Num() - RecordOffset || FCrc::MemCrc32(Data.GetData() + RecordOffset, Size) != Crc)
+		{
+			LOG_STATIC(LogMobileStorePurchaseSystem, "Purchase journal tail dropped at %lld", RecordOffset)
+
+			break;
+		}
+
+		FMemoryReaderView RecordReader(MakeArrayView(Data.GetData() + RecordOffset, Size));
+		Reader.Seek(RecordOffset + Size);
+
+		uint8 RecordType = 0;
+		FString TransactionID;
+		RecordReader << RecordType << TransactionID;
+
+		switch(static_cast<EPurchaseJournalRecord>(RecordType))
+		{
+		case EPurchaseJournalRecord::Recorded:
+			{
+				FPurchaseJournalEntry& Entry = Entries.FindOrAdd(TransactionID);
+				Entry.PurchaseInfo.TransactionID = TransactionID;
+				RecordReader << Entry.PurchaseInfo.ProductID << Entry.PurchaseInfo.CustomData;
+				break;
+			}
+		case EPurchaseJournalRecord::Granted:
+			if(FPurchaseJournalEntry* Entry = Entries.Find(TransactionID))
+			{
+				Entry->State = EPurchaseJournalRecord::Granted;
+			}
+			break;
+		case EPurchaseJournalRecord::Finalized:
+			Entries.Remove(TransactionID);
+			break;
+		default:
+			break;
+		}
+
+		RecordsNum++;
+	}
+
+	return true;
+}
+
+void FPurchaseJournal::Compact()
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	WriteHeader(Writer);
+
+	for(const TTuple<FString, FPurchaseJournalEntry>& Entry : Entries)
+	{
+		WriteRecord(Writer, EPurchaseJournalRecord::Recorded, Entry.Value.PurchaseInfo);
+
+		if(Entry.Value.State == EPurchaseJournalRecord::Granted)
+		{
+			WriteRecord(Writer, EPurchaseJournalRecord::Granted, Entry.Value.PurchaseInfo);
+		}
+	}
+
+	FileHandle.Reset();
+
+	// Crash during rewrite keeps previous journal
+	const FString TempPath = Path + TEXT(".tmp");
+	if(FFileHelper::SaveArrayToFile(Data, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		RecordsNum = Entries.Num();
+	}
+}
+
+bool FPurchaseJournal::OpenForAppend()
+{
+	if(FileHandle.IsValid()) return true;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+	FileHandle.Reset(PlatformFile.OpenWrite(*Path, true, false));
+	if(!FileHandle.IsValid())
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "Purchase journal can't be opened: %s", *Path)
+
+		return false;
+	}
+
+	if(FileHandle->Size() <= 0)
+	{
+		TArray<uint8> Header;
+		FMemoryWriter Writer(Header);
+		WriteHeader(Writer);
+
+		return FileHandle->Write(Header.GetData(), Header.Num());
+	}
+
+	return true;
+}
+
+bool FPurchaseJournal::Append(EPurchaseJournalRecord Type, const FPurchaseInfoRaw& PurchaseInfo)
+{
+	if(!OpenForAppend()) return false;
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	WriteRecord(Writer, Type, PurchaseInfo);
+
+	// Record must reach disk before purchase moves to the next step
+	if(!FileHandle->Write(Data.GetData(), Data.Num()) || !FileHandle->Flush(true))
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "Purchase journal write failed: %s", *PurchaseInfo.TransactionID)
+
+		return false;
+	}
+
+	RecordsNum++;
+
+	return true;
+}
+
+bool FPurchaseJournal::Record(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	if(PurchaseInfo.TransactionID.IsEmpty() || Entries.Contains(PurchaseInfo.TransactionID)) return false;
+
+	FPurchaseJournalEntry& Entry = Entries.Add(PurchaseInfo.TransactionID);
+	Entry.PurchaseInfo = PurchaseInfo;
+
+	return Append(EPurchaseJournalRecord::Recorded, PurchaseInfo);
+}
+
+bool FPurchaseJournal::MarkGranted(const FString& TransactionID)
+{
+	FPurchaseJournalEntry* Entry = Entries.Find(TransactionID);
+	if(!Entry || Entry->State == EPurchaseJournalRecord::Granted) return false;
+
+	Entry->State = EPurchaseJournalRecord::Granted;
+
+	return Append(EPurchaseJournalRecord::Granted, Entry->PurchaseInfo);
+}
+
+bool FPurchaseJournal::MarkFinalized(const FString& TransactionID)
+{
+	FPurchaseJournalEntry Entry;
+	if(!Entries.RemoveAndCopyValue(TransactionID, Entry)) return false;
+
+	const bool bAppended = Append(EPurchaseJournalRecord::Finalized, Entry.PurchaseInfo);
+
+	if(Entries.Num() <= 0 && RecordsNum >= CompactThreshold)
+	{
+		Compact();
+	}
+
+	return bAppended;
+}
@@ -4,14 +4,21 @@
 
 #include "LogSystem.h"
 #include "ManagersSystem.h"
+#include "Catalog/StoreCatalogCache.h"
 #include "Data/ShopItemData.h"
 #include "Data/StoreShopCustomData.h"
 #include "Interfaces/OnlinePurchaseInterface.h"
+#include "Items/ShopItemMobileStorePurchase.h"
 #include "Managers/DataManager.h"
+#include "Module/BillingFlightRecorder.h"
+#include "Module/MobileStorePurchaseStats.h"
 #include "Module/MobileStorePurchaseSystemModule.h"
 #include "Module/MobileStorePurchaseSystemSettings.h"
 #include "Interfaces/OnlineIdentityInterface.h"
+#include "Kismet/GameplayStatics.h"
 #include "PlatformTypePurchases/PlatformTypePurchase.h"
+#include "Proxies/PurchaseDecoder.h"
+#include "Widgets/PurchaseWidget.h"
 
 #if PLATFORM_IOS
 #include "PlatformTypePurchases/PlatformTypePurchaseIOS.h"
@@ -20,9 +27,25 @@
 void UManagerMobileStorePurchase::InitManager()
 {
 	Super::InitManager();
+
+	RebuildProductIndex();
+	LoadProductCatalogCache();
 	
 	InitPlatformInterface();
+	LoadEntitlementCache();
+	LoadPurchaseJournal();
 	RequestAllProducts();
+	ReconcileEntitlementsIfStale();
+
+	if(GetDefault<UMobileStorePurchaseSystemSettings>()->bVerifyPurchaseSignatures)
+	{
+		PurchaseVerifier = MakeUnique<FPurchaseReceiptVerifier>(GetDefault<UMobileStorePurchaseSystemSettings>()->GooglePlayPublicKey);
+	}
+
+	if(GetDefault<UMobileStorePurchaseSystemSettings>()->bPrewarmPurchaseWidget)
+	{
+		PrewarmPurchaseWidget(this);
+	}
 
 	OnlineSubsystem = IOnlineSubsystem::GetByPlatform();
 	if (!OnlineSubsystem) return;
@@ -44,6 +67,42 @@ void UManagerMobileStorePurchase::InitManager()
 #endif
 }
 
+void UManagerMobileStorePurchase::BeginDestroy()
+{
+	if(ProductRequestFlushHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ProductRequestFlushHandle);
+		ProductRequestFlushHandle.Reset();
+	}
+
+	if(ProductPrefetchHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ProductPrefetchHandle);
+		ProductPrefetchHandle.Reset();
+	}
+
+	// Not sent finalizes stay granted in journal and are sent on next start
+	if(FinalizeFlushHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(FinalizeFlushHandle);
+		FinalizeFlushHandle.Reset();
+	}
+
+	if(ProductIndexPublishHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ProductIndexPublishHandle);
+		ProductIndexPublishHandle.Reset();
+	}
+
+	PurchaseWidgetPool.ResetPool();
+	PurchaseWidget = nullptr;
+
+	PurchaseJournal.Reset();
+	PurchaseVerifier.Reset();
+	
+	Super::BeginDestroy();
+}
+
 void UManagerMobileStorePurchase::InitPlatformInterface()
 {
 	if(const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>())
@@ -51,11 +110,7 @@ void UManagerMobileStorePurchase::InitPlatformInterface()
 		if(const TSoftClassPtr<UPurchaseProxyInterface>* ProxyClass =
 			Settings->PlatformsPurchaseInterfaceClasses.Find(FPlatformProperties::IniPlatformName()))
 		{
-			PurchaseInterface = NewObject<UPurchaseProxyInterface>(this, ProxyClass->LoadSynchronous());
-
-			PurchaseInterface->OnProductReceive.AddUObject(this, &UManagerMobileStorePurchase::ReceiveProductInfo);
-			PurchaseInterface->OnProductPurchased.AddUObject(this, &UManagerMobileStorePurchase::ProcessPurchase);
-			PurchaseInterface->OnProductPurchaseError.AddUObject(this, &UManagerMobileStorePurchase::ProcessPurchaseError);
+			SetPurchaseInterface(NewObject<UPurchaseProxyInterface>(this, ProxyClass->LoadSynchronous()));
 			
 			DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
 				LogMobileStorePurchaseSystem,
@@ -69,13 +124,132 @@ void UManagerMobileStorePurchase::InitPlatformInterface()
 	}
 }
 
+void UManagerMobileStorePurchase::SetPurchaseInterface(UPurchaseProxyInterface* InPurchaseInterface)
+{
+	if(PurchaseInterface)
+	{
+		PurchaseInterface->OnProductReceive.RemoveAll(this);
+		PurchaseInterface->OnProductsReceive.RemoveAll(this);
+		PurchaseInterface->OnProductPurchased.RemoveAll(this);
+		PurchaseInterface->OnProductPurchaseError.RemoveAll(this);
+		PurchaseInterface->OnPurchasesFinalized.RemoveAll(this);
+		PurchaseInterface->OnPurchasesRestored.RemoveAll(this);
+		PurchaseInterface->OnPurchasesRestoreComplete.RemoveAll(this);
+		PurchaseInterface->OnConnectionStateChanged.RemoveAll(this);
+	}
+
+	PurchaseInterface = InPurchaseInterface;
+	if(!PurchaseInterface) return;
+
+	PurchaseInterface->OnProductReceive.AddUObject(this, &UManagerMobileStorePurchase::ReceiveProductInfo);
+	PurchaseInterface->OnProductsReceive.AddUObject(this, &UManagerMobileStorePurchase::ReceiveStoreProducts);
+	PurchaseInterface->OnProductPurchased.AddUObject(this, &UManagerMobileStorePurchase::ProcessPurchase);
+	PurchaseInterface->OnProductPurchaseError.AddUObject(this, &UManagerMobileStorePurchase::ProcessPurchaseError);
+	PurchaseInterface->OnPurchasesFinalized.AddUObject(this, &UManagerMobileStorePurchase::ProcessFinalizeResults);
+	PurchaseInterface->OnPurchasesRestored.AddUObject(this, &UManagerMobileStorePurchase::ProcessRestoredPurchases);
+	PurchaseInterface->OnPurchasesRestoreComplete.AddUObject(this, &UManagerMobileStorePurchase::ProcessPurchasesRestoreComplete);
+	PurchaseInterface->OnConnectionStateChanged.AddUObject(this, &UManagerMobileStorePurchase::ProcessConnectionStateChanged);
+}
+
 TSharedPtr<FOnlineStoreOffer> UManagerMobileStorePurchase::GetProduct(FString ProductId) const
 {
-	if (const TSharedPtr<FOnlineStoreOffer>* ProductPtr = StoreProducts.Find(ProductId))
+	return StoreCatalog.GetOffer(StoreCatalog.FindHandle(ProductId));
+}
+
+void UManagerMobileStorePurchase::LoadPurchaseJournal()
+{
+	if(!GetDefault<UMobileStorePurchaseSystemSettings>()->bUsePurchaseJournal) return;
+
+	PurchaseJournal = MakeUnique<FPurchaseJournal>(FPurchaseJournal::GetJournalPath());
+	PurchaseJournal->Load();
+	PurchaseJournal->Compact();
+
+	TArray<FPurchaseInfoRaw> NotGrantedPurchases;
+	TArray<FPurchaseReceiptInfo> GrantedPurchases;
+	
+	for(const TTuple<FString, FPurchaseJournalEntry>& Entry : PurchaseJournal->GetEntries())
 	{
-		return *ProductPtr;
+		if(Entry.Value.State == EPurchaseJournalRecord::Granted)
+		{
+			FPurchaseReceiptInfo& PurchaseReceiptInfo = GrantedPurchases.AddDefaulted_GetRef();
+			PurchaseReceiptInfo.ProductID = Entry.Value.PurchaseInfo.ProductID;
+			PurchaseReceiptInfo.TransactionID = Entry.Value.PurchaseInfo.TransactionID;
+			PurchaseReceiptInfo.CustomData = Entry.Value.PurchaseInfo.CustomData;
+			PurchaseReceiptInfo.ShopItemData = ResolveShopItemByProductId(PurchaseReceiptInfo.ProductID);
+		}
+		else
+		{
+			NotGrantedPurchases.Add(Entry.Value.PurchaseInfo);
+		}
 	}
-	return nullptr;
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase journal: %i granted not finalized, %i not granted",
+		GrantedPurchases.Num(),
+		NotGrantedPurchases.Num()
+	)
+
+	if(GrantedPurchases.Num() <= 0 && NotGrantedPurchases.Num() <= 0) return;
+
+	// Next tick, so store interfaces are ready and listeners bound after manager init get replayed purchases
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, GrantedPurchases, NotGrantedPurchases](float)
+	{
+		// Content is already applied, only store is not told yet
+		for(const FPurchaseReceiptInfo& PurchaseReceiptInfo : GrantedPurchases)
+		{
+			FinalizePurchase(PurchaseReceiptInfo);
+		}
+		
+		for(const FPurchaseInfoRaw& PurchaseInfo : NotGrantedPurchases)
+		{
+			ProcessPurchase(PurchaseInfo);
+		}
+		
+		return false;
+	}));
+}
+
+void UManagerMobileStorePurchase::LoadProductCatalogCache()
+{
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	if(!Settings || !Settings->bUseProductCatalogCache) return;
+
+	TArray<FStoreProduct> CachedProducts;
+	if(!FStoreCatalogCache::Load(FStoreCatalogCache::GetCatalogKey(), FTimespan::FromHours(Settings->ProductCatalogCacheLifetime), CachedProducts)) return;
+
+	TArray<FString> LoadedProductIDs;
+	LoadedProductIDs.Reserve(CachedProducts.Num());
+	StoreCatalog.Reserve(StoreCatalog.Num() + CachedProducts.Num());
+	
+	for(const FStoreProduct& CachedProduct : CachedProducts)
+	{
+		// Never replace products already received from store
+		if(!StoreCatalog.Contains(CachedProduct.ProductID))
+		{
+			StoreCatalog.Add(CachedProduct, false);
+			LoadedProductIDs.Add(CachedProduct.ProductID);
+		}
+	}
+
+	DEBUG_MESSAGE(Settings->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"%i Products loaded from catalog cache",
+		CachedProducts.Num()
+	)
+
+	NotifyProductsUpdated(LoadedProductIDs);
+	UpdateStatCounters();
+}
+
+void UManagerMobileStorePurchase::SaveProductCatalogCache()
+{
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	if(!bCatalogCacheDirty || !Settings || !Settings->bUseProductCatalogCache) return;
+
+	bCatalogCacheDirty = false;
+
+	FStoreCatalogCache::Save(FStoreCatalogCache::GetCatalogKey(), StoreCatalog);
 }
 
 void UManagerMobileStorePurchase::RequestAllProducts()
@@ -88,157 +262,1548 @@ void UManagerMobileStorePurchase::RequestAllProducts()
 	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
 	if(!Settings) return;
 
-	for (FString ProductID : Settings->StoreProductIDs)
+	// Shop items ask for their own products when constructed
+	const EProductRequestPriority Priority = Settings->bDemandDrivenProductFetch ? EProductRequestPriority::Prefetch : EProductRequestPriority::Visible;
+
+	for (const FString& ProductID : Settings->StoreProductIDs)
 	{
-		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
-			LogMobileStorePurchaseSystem,
-			"Add pending ProductID to request - %s",
-			*ProductID
-		)
+		RequestProductId(ProductID, Priority);
+	}
+}
+
+void UManagerMobileStorePurchase::RequestProductId(FString ProductId, EProductRequestPriority Priority)
+{
+	if(ProductId.IsEmpty() || StoreCatalog.IsFresh(ProductId) || ScheduledProductIds.Contains(ProductId)) return;
+
+	if(Priority == EProductRequestPriority::Prefetch)
+	{
+		bool bAlreadyQueued = false;
+		PrefetchProductIdSet.Add(ProductId, &bAlreadyQueued);
+		if(bAlreadyQueued) return;
 
-		PendingProductIdRequests.Add(ProductID);
+		PrefetchProductIds.Add(ProductId);
+		SchedulePrefetch();
+		
+		return;
 	}
 
+	PrefetchProductIdSet.Remove(ProductId);
+	ScheduledProductIds.Add(ProductId);
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Add pending ProductID to request - %s",
+		*ProductId
+	)
+
+	PendingProductIdRequests.Add(ProductId);
+
+	ScheduleProductsRequest();
+}
+
+void UManagerMobileStorePurchase::ScheduleProductsRequest()
+{
+	if(ProductRequestFlushHandle.IsValid()) return;
+
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+
+	// Zero delay ticker fires on next core tick, so everything requested this frame goes in one batch
+	ProductRequestFlushHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UManagerMobileStorePurchase::FlushProductsRequest),
+		Settings ? Settings->ProductRequestCoalesceWindow : 0.f
+	);
+}
+
+bool UManagerMobileStorePurchase::FlushProductsRequest(float DeltaTime)
+{
+	ProductRequestFlushHandle.Reset();
+
 	RequestProducts();
+
+	return false;
 }
 
-void UManagerMobileStorePurchase::RequestProductId(FString ProductId)
+void UManagerMobileStorePurchase::CancelProductRequest(FString ProductId)
 {
-	PendingProductIdRequests.Add(ProductId);
+	if(ProductSubscriptions.Contains(ProductId)) return;
+
+	// Only ids still waiting for flush, sent ones are tracked by their batch
+	if(PendingProductIdRequests.Remove(ProductId) <= 0) return;
+
+	ScheduledProductIds.Remove(ProductId);
+	UpdateStatCounters();
 
-	if (ProductIdRequestsInProgress.Num() <= 0)
+	if(GetDefault<UMobileStorePurchaseSystemSettings>()->bDemandDrivenProductFetch)
 	{
-		RequestProducts();
+		RequestProductId(ProductId, EProductRequestPriority::Prefetch);
 	}
 }
 
-UShopItemData* UManagerMobileStorePurchase::FindShopItemByProductId(FString ProductId) const
+void UManagerMobileStorePurchase::CancelProductPrefetch()
 {
-	const UManagersSystem* ManagersSystem = GetManagerSystem();
-	if(!ManagersSystem) return nullptr;
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Product prefetch cancelled, %i products not requested",
+		PrefetchProductIdSet.Num()
+	)
 
-	const UDataManager* DataManager = ManagersSystem->GetManager<UDataManager>();
-	if(!DataManager) return nullptr;
-	
-	TArray<UShopItemData*> DataAssets = DataManager->GetDataAssets<UShopItemData>();
+	PrefetchProductIds.Reset();
+	PrefetchProductIdSet.Reset();
+	PrefetchQueueHead = 0;
 
-	for (UShopItemData* Data : DataAssets)
+	if(ProductPrefetchHandle.IsValid())
 	{
-		if(Data)
-		{
-			if(const UStoreShopCustomData* StoreShopCustomData = Data->GetCustomData<UStoreShopCustomData>())
-			{
-				if(StoreShopCustomData->ProductID == ProductId) 
-				{
-					return Data;
-				}
-			}
-		}
+		FTSTicker::GetCoreTicker().RemoveTicker(ProductPrefetchHandle);
+		ProductPrefetchHandle.Reset();
 	}
-	
-	return nullptr;
 }
 
-void UManagerMobileStorePurchase::StartPurchase(FString ProductID, bool Consumable)
+void UManagerMobileStorePurchase::CancelProductRequests()
 {
-	if(PurchaseInterface)
+	CancelProductPrefetch();
+
+	for(const FString& ProductId : PendingProductIdRequests)
 	{
-		PurchaseInterface->Purchase(ProductID);
-		return;
+		ScheduledProductIds.Remove(ProductId);
 	}
-	if(PlatformImpl)
+	PendingProductIdRequests.Reset();
+
+	if(ProductRequestFlushHandle.IsValid())
 	{
-		PlatformImpl->Purchase(ProductID, Consumable);
+		FTSTicker::GetCoreTicker().RemoveTicker(ProductRequestFlushHandle);
+		ProductRequestFlushHandle.Reset();
 	}
+
+	UpdateStatCounters();
 }
-void UManagerMobileStorePurchase::RestorePurchases()
+
+void UManagerMobileStorePurchase::SchedulePrefetch()
 {
-	if(PlatformImpl)
+	if(ProductPrefetchHandle.IsValid()) return;
+
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+
+	ProductPrefetchHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UManagerMobileStorePurchase::PrefetchProducts),
+		Settings ? Settings->ProductPrefetchInterval : 1.f
+	);
+}
+
+bool UManagerMobileStorePurchase::PrefetchProducts(float DeltaTime)
+{
+	// Visible requests and store answers go first, check again next period
+	if(PendingProductIdRequests.Num() > 0 || ProductRequestBatches.Num() > 0) return true;
+
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	const int32 BatchSize = Settings ? FMath::Max(Settings->ProductPrefetchBatchSize, 1) : 20;
+
+	while(PrefetchQueueHead < PrefetchProductIds.Num() && PendingProductIdRequests.Num() < BatchSize)
 	{
-		PlatformImpl->RestorePurchases();
+		const FString& ProductId = PrefetchProductIds[PrefetchQueueHead++];
+
+		// Cancelled, promoted or received meanwhile
+		if(!PrefetchProductIdSet.Remove(ProductId) || StoreCatalog.IsFresh(ProductId) || ScheduledProductIds.Contains(ProductId)) continue;
+
+		ScheduledProductIds.Add(ProductId);
+		PendingProductIdRequests.Add(ProductId);
+	}
+
+	if(PendingProductIdRequests.Num() > 0)
+	{
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Prefetch %i products, %i left",
+			PendingProductIdRequests.Num(),
+			PrefetchProductIdSet.Num()
+		)
+
+		RequestProducts();
 	}
+
+	if(PrefetchQueueHead < PrefetchProductIds.Num()) return true;
+
+	PrefetchProductIds.Reset();
+	PrefetchProductIdSet.Reset();
+	PrefetchQueueHead = 0;
+	ProductPrefetchHandle.Reset();
+
+	return false;
 }
 
-void UManagerMobileStorePurchase::FinalizePurchase(FPurchaseReceiptInfo PurchaseReceiptInfo)
+UShopItemData* UManagerMobileStorePurchase::FindShopItemByProductId(FString ProductId) const
 {
-	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>(),
-		LogMobileStorePurchaseSystem,
-		"Finalize purchase: %s",
-		*PurchaseReceiptInfo.ProductID
-	);
-	
-	if(PurchaseInterface)
+	MOBILE_STORE_PURCHASE_SCOPE(FindShopItem);
+
+	if(const FStoreProductIndexEntry* Entry = ProductIndex.Find(ProductId))
 	{
-		FPurchaseInfoRaw PurchaseInfoRaw;
-		PurchaseInfoRaw.ProductID = PurchaseReceiptInfo.ProductID;
-		PurchaseInfoRaw.TransactionID = PurchaseReceiptInfo.TransactionID;
-		PurchaseInfoRaw.CustomData = PurchaseReceiptInfo.CustomData;
+		if(UShopItemData* Data = Entry->ShopItemData.Get())
+		{
+			return Data;
+		}
+	}
 
-		// We need to consume or acknowledge, so we need to place info in custom data
-		PurchaseInfoRaw.CustomData.Add(
-			"FinalizeType",
-			(PurchaseReceiptInfo.ShopItemData && PurchaseReceiptInfo.ShopItemData->GetCustomData<UStoreShopCustomData>()) ? 
-				PurchaseReceiptInfo.ShopItemData->GetCustomData<UStoreShopCustomData>()->bIsConsumable ? 
-				"Consume" : 
-				"Acknowledge": 
-				"Consume"
-		);
-		
-		PurchaseInterface->FinalizePurchase(PurchaseInfoRaw);
-		
-		return;
+	// Loaded after index was built or unloaded without being removed from it
+	return ScanShopItemByProductId(ProductId);
+}
+
+UShopItemData* UManagerMobileStorePurchase::ResolveShopItemByProductId(const FString& ProductId)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(FindShopItem);
+
+	if(const FStoreProductIndexEntry* Entry = ProductIndex.Find(ProductId))
+	{
+		if(UShopItemData* Data = Entry->ShopItemData.Get())
+		{
+			return Data;
+		}
+	}
+
+	UShopItemData* Data = ScanShopItemByProductId(ProductId);
+	if(Data)
+	{
+		AddShopItemDataToIndex(Data);
+	}
+	else if(ProductIndex.Remove(ProductId) > 0)
+	{
+		MarkProductIndexDirty();
 	}
 
-	if(OnlinePurchase) OnlinePurchase->FinalizePurchase(*UniqueNetId, PurchaseReceiptInfo.TransactionID);
+	return Data;
 }
 
-void UManagerMobileStorePurchase::RequestProducts()
+UShopItemData* UManagerMobileStorePurchase::ScanShopItemByProductId(const FString& ProductId) const
 {
-	if(PendingProductIdRequests.Num() <= 0) return;
-	
-	if(PurchaseInterface)
+	if(ProductId.IsEmpty() || MissingProductIds.Contains(ProductId)) return nullptr;
+
+	const UManagersSystem* ManagersSystem = GetManagerSystem();
+	if(!ManagersSystem) return nullptr;
+
+	const UDataManager* DataManager = ManagersSystem->GetManager<UDataManager>();
+	if(!DataManager) return nullptr;
+
+	for (UShopItemData* Data : DataManager->GetDataAssets<UShopItemData>())
 	{
-		PurchaseInterface->RequestProducts(PendingProductIdRequests);
-		return;
+		if(!Data) continue;
+
+		const UStoreShopCustomData* StoreShopCustomData = Data->GetCustomData<UStoreShopCustomData>();
+		if(StoreShopCustomData && StoreShopCustomData->ProductID == ProductId)
+		{
+			return Data;
+		}
 	}
-	
-	if (PlatformImpl)
+
+	MissingProductIds.Add(ProductId);
+
+	return nullptr;
+}
+
+bool UManagerMobileStorePurchase::IsProductConsumable(FString ProductId)
+{
+	if(const FStoreProductIndexEntry* Entry = ProductIndex.Find(ProductId))
 	{
-		PlatformImpl->RequestProducts();
+		return Entry->bIsConsumable;
 	}
+
+	// Unknown products are consumed, same as before index was introduced
+	const UShopItemData* Data = ResolveShopItemByProductId(ProductId);
+	const UStoreShopCustomData* StoreShopCustomData = Data ? Data->GetCustomData<UStoreShopCustomData>() : nullptr;
+	
+	return !StoreShopCustomData || StoreShopCustomData->bIsConsumable;
 }
 
-void UManagerMobileStorePurchase::ReceiveProductInfo(TSharedPtr<FOnlineStoreOffer> ProductInfo)
+void UManagerMobileStorePurchase::AddShopItemDataToIndex(UShopItemData* ShopItemData)
 {
-	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
-		LogMobileStorePurchaseSystem,
-		"Product info received: %s -- %s",
-		*ProductInfo->OfferId,
-		*ProductInfo->PriceText.ToString()
-	);
+	if(!ShopItemData) return;
+
+	const UStoreShopCustomData* StoreShopCustomData = ShopItemData->GetCustomData<UStoreShopCustomData>();
+	if(!StoreShopCustomData || StoreShopCustomData->ProductID.IsEmpty()) return;
+
+	AddProductToIndex(StoreShopCustomData->ProductID, ShopItemData, StoreShopCustomData->bIsConsumable);
+}
+
+void UManagerMobileStorePurchase::AddProductToIndex(const FString& ProductId, UShopItemData* ShopItemData, bool bIsConsumable)
+{
+	MissingProductIds.Remove(ProductId);
 	
-	StoreProducts.Add(ProductInfo->OfferId, ProductInfo);
+	FStoreProductIndexEntry& Entry = ProductIndex.FindOrAdd(ProductId);
+	if(Entry.ShopItemData == ShopItemData && Entry.bIsConsumable == bIsConsumable) return;
 	
-	OnProductsReceived.Broadcast();
+	Entry.ShopItemData = ShopItemData;
+	Entry.bIsConsumable = bIsConsumable;
+
+	MarkProductIndexDirty();
 }
 
-void UManagerMobileStorePurchase::ProcessPurchase(FPurchaseInfoRaw PurchaseInfo)
+void UManagerMobileStorePurchase::RemoveShopItemDataFromIndex(UShopItemData* ShopItemData)
 {
-	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
-		LogMobileStorePurchaseSystem,
-		"Process purchase in manager: %s",
-		*PurchaseInfo.ProductID
-	);
-	
-	FPurchaseReceiptInfo PurchaseReceiptInfo;
-	PurchaseReceiptInfo.ProductID = PurchaseInfo.ProductID;
-	PurchaseReceiptInfo.TransactionID = PurchaseInfo.TransactionID;
-	PurchaseReceiptInfo.CustomData = PurchaseInfo.CustomData;
-	PurchaseReceiptInfo.ShopItemData = FindShopItemByProductId(PurchaseInfo.ProductID);
-	OnPurchaseComplete.Broadcast(true, PurchaseReceiptInfo);
+	if(!ShopItemData) return;
+
+	if(const UStoreShopCustomData* StoreShopCustomData = ShopItemData->GetCustomData<UStoreShopCustomData>())
+	{
+		const FStoreProductIndexEntry* Entry = ProductIndex.Find(StoreShopCustomData->ProductID);
+		if(Entry && Entry->ShopItemData == ShopItemData)
+		{
+			ProductIndex.Remove(StoreShopCustomData->ProductID);
+			MarkProductIndexDirty();
+		}
+	}
 }
 
-void UManagerMobileStorePurchase::ProcessPurchaseError(FString Error)
+void UManagerMobileStorePurchase::RebuildProductIndex()
 {
-	OnPurchaseComplete.Broadcast(false, FPurchaseReceiptInfo());
+	ProductIndex.Reset();
+	MissingProductIds.Reset();
+	MarkProductIndexDirty();
+
+	const UManagersSystem* ManagersSystem = GetManagerSystem();
+	if(!ManagersSystem) return;
+
+	const UDataManager* DataManager = ManagersSystem->GetManager<UDataManager>();
+	if(!DataManager) return;
+
+	const TArray<UShopItemData*> DataAssets = DataManager->GetDataAssets<UShopItemData>();
+
+	ProductIndex.Reserve(DataAssets.Num());
+	for (UShopItemData* Data : DataAssets)
+	{
+		AddShopItemDataToIndex(Data);
+	}
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Product index built: %i store products",
+		ProductIndex.Num()
+	)
+}
+
+void UManagerMobileStorePurchase::MarkProductIndexDirty()
+{
+	if(ProductIndexPublishHandle.IsValid()) return;
+
+	ProductIndexPublishHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UManagerMobileStorePurchase::PublishProductIndex));
+}
+
+bool UManagerMobileStorePurchase::PublishProductIndex(float DeltaTime)
+{
+	ProductIndexPublishHandle.Reset();
+
+	TMap<FString, TWeakObjectPtr<UShopItemData>> DecoderProductIndex;
+	DecoderProductIndex.Reserve(ProductIndex.Num());
+	
+	for(const TTuple<FString, FStoreProductIndexEntry>& Entry : ProductIndex)
+	{
+		DecoderProductIndex.Add(Entry.Key, Entry.Value.ShopItemData);
+	}
+
+	FPurchaseDecoder::Get().SetProductIndex(MoveTemp(DecoderProductIndex));
+
+	return false;
+}
+
+void UManagerMobileStorePurchase::StartPurchase(FString ProductID, bool Consumable)
+{
+	StartPurchase(ProductID, Consumable, FPurchaseCompleteDelegate());
+}
+
+int32 UManagerMobileStorePurchase::StartPurchase(FString ProductID, bool Consumable, FPurchaseCompleteDelegate OnComplete, FPurchasePendingDelegate OnPending)
+{
+	const int32 RequestID = ++LastPurchaseRequestID;
+
+	FPurchaseTransaction& Transaction = PurchaseTransactions.Add(RequestID);
+	Transaction.RequestID = RequestID;
+	Transaction.ProductID = ProductID;
+	Transaction.State = EPurchaseTransactionState::Requested;
+	Transaction.StartTime = FPlatformTime::Seconds();
+	Transaction.OnComplete = MoveTemp(OnComplete);
+	Transaction.OnPending = MoveTemp(OnPending);
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseStarted, ProductID, FString(), RequestID);
+	UpdateStatCounters();
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase request %i: %s, %i purchases open",
+		RequestID,
+		*ProductID,
+		PurchaseTransactions.Num()
+	)
+
+	if(!PurchaseInterface && !PlatformImpl)
+	{
+		FailPurchaseRequest(RequestID, "No purchase interface");
+		
+		return RequestID;
+	}
+
+	// Set before calling store, proxies may answer synchronously
+	Transaction.State = EPurchaseTransactionState::FlowLaunched;
+	
+	if(PurchaseInterface)
+	{
+		PurchaseInterface->Purchase(ProductID);
+	}
+	else
+	{
+		PlatformImpl->Purchase(ProductID, Consumable);
+	}
+
+	return RequestID;
+}
+
+void UManagerMobileStorePurchase::RegisterShopItem(UShopItemMobileStorePurchase* ShopItem)
+{
+	if(!ShopItem) return;
+
+	const FString ProductID = ShopItem->GetProductID();
+	if(ProductID.IsEmpty()) return;
+
+	ShopItemsByProduct.Add(ProductID, ShopItem);
+
+	TArray<FPurchaseReceiptInfo> Purchases;
+	if(!UnclaimedPurchases.RemoveAndCopyValue(ProductID, Purchases)) return;
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"%i unclaimed purchases of %s handed to shop item",
+		Purchases.Num(),
+		*ProductID
+	)
+
+	for(const FPurchaseReceiptInfo& PurchaseReceiptInfo : Purchases)
+	{
+		ShopItem->GrantRecoveredPurchase(PurchaseReceiptInfo);
+	}
+}
+
+void UManagerMobileStorePurchase::RemoveUnclaimedPurchase(const FString& ProductID, const FString& TransactionID)
+{
+	TArray<FPurchaseReceiptInfo>* Purchases = UnclaimedPurchases.Find(ProductID);
+	if(!Purchases) return;
+
+	Purchases->RemoveAllSwap([&TransactionID](const FPurchaseReceiptInfo& PurchaseReceiptInfo)
+	{
+		return PurchaseReceiptInfo.TransactionID == TransactionID;
+	});
+
+	if(Purchases->Num() <= 0)
+	{
+		UnclaimedPurchases.Remove(ProductID);
+	}
+}
+
+void UManagerMobileStorePurchase::UnregisterShopItem(const UShopItemMobileStorePurchase* ShopItem)
+{
+	for(auto It = ShopItemsByProduct.CreateIterator(); It; ++It)
+	{
+		if(!It->Value.IsValid() || It->Value.Get() == ShopItem)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+int32 UManagerMobileStorePurchase::FindPurchaseRequest(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	int32 RequestID = INDEX_NONE;
+	if(PurchaseInfo.TransactionID.IsEmpty() || !PendingPurchaseRequestIDs.RemoveAndCopyValue(PurchaseInfo.TransactionID, RequestID) || !PurchaseTransactions.Contains(RequestID))
+	{
+		RequestID = FindLaunchedPurchaseRequest(PurchaseInfo.ProductID);
+	}
+
+	return RequestID;
+}
+
+int32 UManagerMobileStorePurchase::FindLaunchedPurchaseRequest(const FString& ProductID) const
+{
+	int32 FoundRequestID = INDEX_NONE;
+	
+	for(const TTuple<int32, FPurchaseTransaction>& Transaction : PurchaseTransactions)
+	{
+		if(Transaction.Value.State != EPurchaseTransactionState::FlowLaunched) continue;
+
+		if(ProductID.IsEmpty())
+		{
+			// Only one store flow is visible at a time, so unnamed answer belongs to the last one
+			FoundRequestID = FMath::Max(FoundRequestID, Transaction.Key);
+		}
+		else if(Transaction.Value.ProductID == ProductID && (FoundRequestID == INDEX_NONE || Transaction.Key < FoundRequestID))
+		{
+			FoundRequestID = Transaction.Key;
+		}
+	}
+
+	return FoundRequestID;
+}
+
+void UManagerMobileStorePurchase::FailPurchaseRequest(int32 RequestID, const FString& Error)
+{
+	FPurchaseTransaction Transaction;
+	if(!PurchaseTransactions.RemoveAndCopyValue(RequestID, Transaction)) return;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseFailed, Transaction.ProductID, Transaction.TransactionID, RequestID);
+	FBillingFlightRecorder::Get().DumpOnError();
+
+	UpdateStatCounters();
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase request %i: %s failed - %s",
+		RequestID,
+		*Transaction.ProductID,
+		*Error
+	)
+
+	FPurchaseReceiptInfo PurchaseReceiptInfo;
+	PurchaseReceiptInfo.ProductID = Transaction.ProductID;
+	PurchaseReceiptInfo.ShopItemData = ResolveShopItemByProductId(Transaction.ProductID);
+
+	Transaction.OnComplete.ExecuteIfBound(false, PurchaseReceiptInfo);
+	OnPurchaseComplete.Broadcast(false, PurchaseReceiptInfo);
+}
+
+void UManagerMobileStorePurchase::MarkPurchaseGranted(FString TransactionID)
+{
+	if(PurchaseJournal)
+	{
+		PurchaseJournal->MarkGranted(TransactionID);
+	}
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseGranted, FString(), TransactionID);
+	
+	const int32* RequestID = PurchaseRequestIDs.Find(TransactionID);
+	if(!RequestID) return;
+
+	FPurchaseTransaction& Transaction = PurchaseTransactions.FindChecked(*RequestID);
+	if(Transaction.State == EPurchaseTransactionState::Purchased)
+	{
+		Transaction.State = EPurchaseTransactionState::Granted;
+	}
+
+	RemoveUnclaimedPurchase(Transaction.ProductID, TransactionID);
+
+	if(!IsProductConsumable(Transaction.ProductID))
+	{
+		GrantEntitlement(Transaction.ProductID, TransactionID);
+	}
+}
+
+bool UManagerMobileStorePurchase::SetPurchaseWidgetWorld(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if(!World) return false;
+
+	if(PurchaseWidgetWorld.Get() != World)
+	{
+		// Widgets of previous world are destroyed with it
+		PurchaseWidgetPool.ResetPool();
+		PurchaseWidgetPool.SetWorld(World);
+		PurchaseWidgetWorld = World;
+		PurchaseWidget = nullptr;
+		PurchaseWidgetShowCount = 0;
+		bPurchaseWidgetPrewarmed = false;
+	}
+
+	PurchaseWidgetPool.SetDefaultPlayerController(UGameplayStatics::GetPlayerController(World, 0));
+
+	return true;
+}
+
+void UManagerMobileStorePurchase::PrewarmPurchaseWidget(const UObject* WorldContextObject)
+{
+	if(!SetPurchaseWidgetWorld(WorldContextObject) || bPurchaseWidgetPrewarmed || PurchaseWidget) return;
+
+	bPurchaseWidgetPrewarmed = true;
+
+	// Released widget keeps its slate tree, next show reuses it
+	if(UPurchaseWidget* Widget = PurchaseWidgetPool.GetOrCreateInstance<UPurchaseWidget>(GetDefault<UMobileStorePurchaseSystemSettings>()->PurchaseWidgetClass))
+	{
+		Widget->TakeWidget();
+		PurchaseWidgetPool.Release(Widget);
+	}
+}
+
+UPurchaseWidget* UManagerMobileStorePurchase::ShowPurchaseWidget(const UObject* WorldContextObject)
+{
+	if(!SetPurchaseWidgetWorld(WorldContextObject)) return nullptr;
+
+	PurchaseWidgetShowCount++;
+	if(PurchaseWidget) return PurchaseWidget;
+
+	PurchaseWidget = PurchaseWidgetPool.GetOrCreateInstance<UPurchaseWidget>(GetDefault<UMobileStorePurchaseSystemSettings>()->PurchaseWidgetClass);
+	if(PurchaseWidget)
+	{
+		PurchaseWidget->Show();
+	}
+
+	return PurchaseWidget;
+}
+
+void UManagerMobileStorePurchase::HidePurchaseWidget()
+{
+	if(PurchaseWidgetShowCount <= 0) return;
+	
+	if(--PurchaseWidgetShowCount > 0 || !PurchaseWidget) return;
+
+	PurchaseWidget->Hide();
+	PurchaseWidgetPool.Release(PurchaseWidget);
+	PurchaseWidget = nullptr;
+}
+
+EBillingConnectionState UManagerMobileStorePurchase::GetBillingConnectionState() const
+{
+	return PurchaseInterface ? PurchaseInterface->GetConnectionState() : EBillingConnectionState::Connected;
+}
+
+void UManagerMobileStorePurchase::ProcessConnectionStateChanged(EBillingConnectionState State, float ConnectSeconds)
+{
+	if(State == EBillingConnectionState::Connected)
+	{
+		LastBillingConnectTime = ConnectSeconds;
+
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Billing connected in %f ms",
+			ConnectSeconds * 1000.f
+		)
+
+		// Queries dropped while store was unreachable and products that went stale meanwhile
+		RequestAllProducts();
+	}
+
+	OnBillingConnectionStateChanged.Broadcast(State);
+}
+
+void UManagerMobileStorePurchase::ReportPurchaseStartLatency(double Seconds)
+{
+	LastPurchaseStartLatency = Seconds;
+	TotalPurchaseStartLatency += Seconds;
+	PurchaseStartsNum++;
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase flow started in %f ms, average %f ms",
+		Seconds * 1000.0,
+		GetAveragePurchaseStartLatency() * 1000.f
+	)
+}
+
+EPurchaseTransactionState UManagerMobileStorePurchase::GetPurchaseRequestState(int32 RequestID) const
+{
+	const FPurchaseTransaction* Transaction = PurchaseTransactions.Find(RequestID);
+	return Transaction ? Transaction->State : EPurchaseTransactionState::None;
+}
+
+EPurchaseTransactionState UManagerMobileStorePurchase::GetTransactionState(FString TransactionID) const
+{
+	if(FinalizedTransactionIDs.Contains(TransactionID)) return EPurchaseTransactionState::Finalized;
+
+	// Pending purchase without open request still has a state
+	if(const int32* PendingRequestID = PendingPurchaseRequestIDs.Find(TransactionID))
+	{
+		return *PendingRequestID != INDEX_NONE ? GetPurchaseRequestState(*PendingRequestID) : EPurchaseTransactionState::Pending;
+	}
+
+	const int32* RequestID = PurchaseRequestIDs.Find(TransactionID);
+	return RequestID ? GetPurchaseRequestState(*RequestID) : EPurchaseTransactionState::None;
+}
+
+void UManagerMobileStorePurchase::RestorePurchases()
+{
+	if(PurchaseInterface)
+	{
+		if(bRestoreInProgress) return;
+
+		bRestoreInProgress = true;
+		RestoredPurchasesNum = 0;
+		RestoreOwnedProducts.Reset();
+		RestoreVerifyingProducts.Reset();
+		bRestoreReconcilePending = false;
+
+		FBillingFlightRecorder::Get().Record(EBillingFlightEvent::RestoreStarted);
+		
+		PurchaseInterface->RestorePurchases();
+		
+		return;
+	}
+	
+	if(PlatformImpl)
+	{
+		PlatformImpl->RestorePurchases();
+	}
+}
+
+void UManagerMobileStorePurchase::ProcessRestoredPurchases(const TArray<FPurchaseInfoRaw>& Purchases)
+{
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Restored purchases part: %i",
+		Purchases.Num()
+	)
+	
+	for(const FPurchaseInfoRaw& PurchaseInfo : Purchases)
+	{
+		const FString& TransactionID = PurchaseInfo.TransactionID;
+		if(TransactionID.IsEmpty()) continue;
+
+		const FString* PurchaseState = PurchaseInfo.CustomData.Find("PurchaseState");
+		const FString* Acknowledged = PurchaseInfo.CustomData.Find("Acknowledged");
+		const bool bAcknowledged = Acknowledged && *Acknowledged == "True";
+
+		// Reported again when it is approved
+		if(IsPendingPurchase(PurchaseInfo)) continue;
+
+		if(!bAcknowledged)
+		{
+			// Store still waits for finalize, so content may not be granted yet. Repeats are dropped by purchase pipeline
+			ProcessPurchase(PurchaseInfo);
+			TrackRestoredOwnership(PurchaseInfo);
+			continue;
+		}
+
+		// Handled by this session already
+		if(FinalizedTransactionIDs.Contains(TransactionID) || PurchaseRequestIDs.Contains(TransactionID) || VerifyingTransactionIDs.Contains(TransactionID))
+		{
+			TrackRestoredOwnership(PurchaseInfo);
+			continue;
+		}
+
+		const bool bOwnable = !IsProductConsumable(PurchaseInfo.ProductID);
+
+		// Same answer as last restore, it passed checks then
+		const FString RestoreState = PurchaseState ? *PurchaseState : FString();
+		if(const FString* KnownState = KnownRestoreStates.Find(TransactionID))
+		{
+			if(*KnownState == RestoreState)
+			{
+				// Repeated part while its check is running
+				if(bOwnable && !RestoreVerifyingProducts.Contains(TransactionID))
+				{
+					RestoreOwnedProducts.Add(PurchaseInfo.ProductID, TransactionID);
+				}
+
+				continue;
+			}
+		}
+		KnownRestoreStates.Add(TransactionID, RestoreState);
+
+		if(PurchaseVerifier && FPurchaseReceiptVerifier::NeedsVerification(PurchaseInfo) && !PurchaseVerifier->IsVerified(PurchaseInfo))
+		{
+			if(bOwnable)
+			{
+				RestoreVerifyingProducts.Add(TransactionID, PurchaseInfo.ProductID);
+			}
+			
+			PurchaseVerifier->Verify(PurchaseInfo, FPurchaseVerifyDelegate::CreateWeakLambda(this, [this, PurchaseInfo](bool bValid, const FString& Error)
+			{
+				if(bValid)
+				{
+					BroadcastRestoredPurchase(PurchaseInfo);
+				}
+				else
+				{
+					LOG(LogMobileStorePurchaseSystem, "Restored purchase %s rejected: %s", *PurchaseInfo.ProductID, *Error)
+
+					// Checked again on next restore
+					KnownRestoreStates.Remove(PurchaseInfo.TransactionID);
+				}
+
+				ResolveRestoredOwnership(PurchaseInfo.TransactionID, bValid);
+			}));
+			
+			continue;
+		}
+
+		if(bOwnable)
+		{
+			RestoreOwnedProducts.Add(PurchaseInfo.ProductID, TransactionID);
+		}
+
+		BroadcastRestoredPurchase(PurchaseInfo);
+	}
+}
+
+void UManagerMobileStorePurchase::TrackRestoredOwnership(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	const FString& TransactionID = PurchaseInfo.TransactionID;
+	if(IsProductConsumable(PurchaseInfo.ProductID)) return;
+
+	// Journal and granted records are written only for accepted purchases
+	const bool bAccepted = PurchaseRequestIDs.Contains(TransactionID) ||
+		FinalizedTransactionIDs.Contains(TransactionID) ||
+		GrantedTransactions.Contains(TransactionID) ||
+		(PurchaseJournal && PurchaseJournal->Find(TransactionID));
+
+	if(bAccepted)
+	{
+		RestoreOwnedProducts.Add(PurchaseInfo.ProductID, TransactionID);
+	}
+	else if(VerifyingTransactionIDs.Contains(TransactionID))
+	{
+		// Added by AcceptPurchase, dropped by RejectPurchase
+		RestoreVerifyingProducts.Add(TransactionID, PurchaseInfo.ProductID);
+	}
+}
+
+void UManagerMobileStorePurchase::ResolveRestoredOwnership(const FString& TransactionID, bool bOwned)
+{
+	FString ProductID;
+	if(!RestoreVerifyingProducts.RemoveAndCopyValue(TransactionID, ProductID)) return;
+
+	if(bOwned)
+	{
+		RestoreOwnedProducts.Add(ProductID, TransactionID);
+	}
+
+	if(bRestoreReconcilePending && RestoreVerifyingProducts.Num() == 0)
+	{
+		ReconcileRestoredEntitlements();
+	}
+}
+
+void UManagerMobileStorePurchase::ReconcileRestoredEntitlements()
+{
+	bRestoreReconcilePending = false;
+
+	if(EntitlementCache)
+	{
+		const bool bChanged = EntitlementCache->Reconcile(RestoreOwnedProducts);
+		EntitlementCache->Save();
+
+		if(bChanged)
+		{
+			OnEntitlementsChanged.Broadcast();
+		}
+	}
+	
+	RestoreOwnedProducts.Reset();
+}
+
+void UManagerMobileStorePurchase::BroadcastRestoredPurchase(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	FPurchaseReceiptInfo RestoreReceipt;
+	RestoreReceipt.ProductID = PurchaseInfo.ProductID;
+	RestoreReceipt.TransactionID = PurchaseInfo.TransactionID;
+	RestoreReceipt.CustomData = PurchaseInfo.CustomData;
+	RestoreReceipt.ShopItemData = PurchaseInfo.ShopItemData.Get();
+	if(!RestoreReceipt.ShopItemData)
+	{
+		RestoreReceipt.ShopItemData = ResolveShopItemByProductId(PurchaseInfo.ProductID);
+	}
+
+	RestoredPurchasesNum++;
+
+	if(!IsProductConsumable(PurchaseInfo.ProductID))
+	{
+		GrantEntitlement(PurchaseInfo.ProductID, PurchaseInfo.TransactionID);
+	}
+	
+	OnPurchaseRestore.Broadcast(true, RestoreReceipt);
+}
+
+void UManagerMobileStorePurchase::ProcessPurchasesRestoreComplete(bool bSuccess, FString Error)
+{
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Restore complete: %s, %i new purchases %s",
+		bSuccess ? TEXT("success") : TEXT("fail"),
+		RestoredPurchasesNum,
+		*Error
+	)
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::RestoreComplete, FString(), FString(), bSuccess ? RestoredPurchasesNum : -1);
+	
+	bRestoreInProgress = false;
+
+	// Only full store answer can drop entitlements. Purchases still being verified are waited for
+	if(bSuccess)
+	{
+		bRestoreReconcilePending = true;
+
+		if(RestoreVerifyingProducts.Num() == 0)
+		{
+			ReconcileRestoredEntitlements();
+		}
+	}
+	else
+	{
+		RestoreOwnedProducts.Reset();
+		RestoreVerifyingProducts.Reset();
+	}
+
+	OnPurchaseRestoreComplete.Broadcast(bSuccess, RestoredPurchasesNum);
+}
+
+void UManagerMobileStorePurchase::LoadEntitlementCache()
+{
+	if(!GetDefault<UMobileStorePurchaseSystemSettings>()->bUseEntitlementCache) return;
+
+	EntitlementCache = MakeUnique<FEntitlementCache>();
+	EntitlementCache->Load();
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"%i Owned products loaded from entitlement cache",
+		EntitlementCache->GetOwnedProducts().Num()
+	)
+}
+
+bool UManagerMobileStorePurchase::ReconcileEntitlementsIfStale()
+{
+	if(!EntitlementCache || !PurchaseInterface || bRestoreInProgress) return false;
+
+	const float ReconcileInterval = GetDefault<UMobileStorePurchaseSystemSettings>()->EntitlementReconcileInterval;
+	if(!EntitlementCache->IsStale(FTimespan::FromHours(ReconcileInterval))) return false;
+
+	RestorePurchases();
+
+	return true;
+}
+
+TArray<FString> UManagerMobileStorePurchase::GetOwnedProducts() const
+{
+	TArray<FString> OwnedProducts;
+	if(EntitlementCache)
+	{
+		EntitlementCache->GetOwnedProducts().GenerateKeyArray(OwnedProducts);
+	}
+
+	return OwnedProducts;
+}
+
+void UManagerMobileStorePurchase::GrantEntitlement(const FString& ProductID, const FString& TransactionID)
+{
+	if(!EntitlementCache || !EntitlementCache->Grant(ProductID, TransactionID)) return;
+
+	EntitlementCache->Save();
+	OnEntitlementsChanged.Broadcast();
+}
+
+void UManagerMobileStorePurchase::FinalizePurchase(FPurchaseReceiptInfo PurchaseReceiptInfo)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(FinalizePurchase);
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::FinalizeRequested, PurchaseReceiptInfo.ProductID, PurchaseReceiptInfo.TransactionID);
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>(),
+		LogMobileStorePurchaseSystem,
+		"Finalize purchase: %s",
+		*PurchaseReceiptInfo.ProductID
+	);
+
+	// Journal entry stays unfinished until some store can take it
+	if(!PurchaseInterface && !(OnlinePurchase && UniqueNetId)) return;
+
+	if(!PurchaseReceiptInfo.TransactionID.IsEmpty())
+	{
+		bool bAlreadyFinalized = false;
+		FinalizedTransactionIDs.Add(PurchaseReceiptInfo.TransactionID, &bAlreadyFinalized);
+		if(bAlreadyFinalized) return;
+
+		GrantedTransactions.Add(PurchaseReceiptInfo.TransactionID, PurchaseReceiptInfo);
+		RemoveUnclaimedPurchase(PurchaseReceiptInfo.ProductID, PurchaseReceiptInfo.TransactionID);
+
+		int32 RequestID = INDEX_NONE;
+		if(PurchaseRequestIDs.RemoveAndCopyValue(PurchaseReceiptInfo.TransactionID, RequestID))
+		{
+			PurchaseTransactions.Remove(RequestID);
+			UpdateStatCounters();
+		}
+	}
+
+	// Content is granted by the time purchase is finalized, even if MarkPurchaseGranted was not called
+	if(!IsProductConsumable(PurchaseReceiptInfo.ProductID))
+	{
+		GrantEntitlement(PurchaseReceiptInfo.ProductID, PurchaseReceiptInfo.TransactionID);
+	}
+	
+	if(PurchaseInterface)
+	{
+		FPurchaseInfoRaw PurchaseInfoRaw;
+		PurchaseInfoRaw.ProductID = PurchaseReceiptInfo.ProductID;
+		PurchaseInfoRaw.TransactionID = PurchaseReceiptInfo.TransactionID;
+		PurchaseInfoRaw.CustomData = PurchaseReceiptInfo.CustomData;
+
+		// We need to consume or acknowledge, so we need to place info in custom data
+		PurchaseInfoRaw.CustomData.Add(
+			"FinalizeType",
+			IsProductConsumable(PurchaseReceiptInfo.ProductID) ? "Consume" : "Acknowledge"
+		);
+
+		// Journal entry is finished when store confirms it in ProcessFinalizeResults
+		PendingFinalizePurchases.Add(MoveTemp(PurchaseInfoRaw));
+
+		if(!FinalizeFlushHandle.IsValid())
+		{
+			FinalizeFlushHandle = FTSTicker::GetCoreTicker().AddTicker(
+				FTickerDelegate::CreateUObject(this, &UManagerMobileStorePurchase::FlushFinalizePurchases)
+			);
+		}
+		
+		return;
+	}
+
+	OnlinePurchase->FinalizePurchase(*UniqueNetId, PurchaseReceiptInfo.TransactionID);
+
+	// Online subsystem does not report finalize result
+	if(PurchaseJournal)
+	{
+		PurchaseJournal->MarkFinalized(PurchaseReceiptInfo.TransactionID);
+	}
+}
+
+bool UManagerMobileStorePurchase::FlushFinalizePurchases(float DeltaTime)
+{
+	FinalizeFlushHandle.Reset();
+
+	if(!PurchaseInterface || PendingFinalizePurchases.Num() <= 0) return false;
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Finalize %i purchases",
+		PendingFinalizePurchases.Num()
+	)
+
+	const TArray<FPurchaseInfoRaw> Purchases = MoveTemp(PendingFinalizePurchases);
+	PendingFinalizePurchases.Reset();
+
+	MOBILE_STORE_PURCHASE_SCOPE(FinalizePurchase);
+
+	PurchaseInterface->FinalizePurchases(Purchases);
+	UpdateStatCounters();
+
+	return false;
+}
+
+void UManagerMobileStorePurchase::ProcessFinalizeResults(const TArray<FPurchaseFinalizeResult>& Results)
+{
+	for(const FPurchaseFinalizeResult& Result : Results)
+	{
+		FBillingFlightRecorder::Get().Record(EBillingFlightEvent::FinalizeResult, FString(), Result.TransactionID, Result.bSuccess ? 0 : 1);
+
+		if(Result.bSuccess)
+		{
+			GrantedTransactions.Remove(Result.TransactionID);
+			
+			if(PurchaseJournal)
+			{
+				PurchaseJournal->MarkFinalized(Result.TransactionID);
+			}
+
+			continue;
+		}
+
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Finalize failed: %s - %s",
+			*Result.TransactionID,
+			*Result.Error
+		)
+
+		// Store redelivers it, GrantedTransactions makes sure it is only finalized again
+		FinalizedTransactionIDs.Remove(Result.TransactionID);
+	}
+
+	OnPurchasesFinalized.Broadcast(Results);
+}
+
+void UManagerMobileStorePurchase::RequestProducts()
+{
+	if(PendingProductIdRequests.Num() <= 0) return;
+
+	MOBILE_STORE_PURCHASE_SCOPE(RequestProducts);
+	
+	if(PurchaseInterface)
+	{
+		const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+		const int32 MaxBatchSize = Settings ? FMath::Max(Settings->MaxProductRequestBatchSize, 1) : 100;
+		const float Timeout = Settings ? Settings->ProductRequestTimeout : 30.f;
+
+		TArray<FString> ProductIDs = MoveTemp(PendingProductIdRequests);
+		PendingProductIdRequests.Reset();
+
+		for(int32 Offset = 0; Offset < ProductIDs.Num(); Offset += MaxBatchSize)
+		{
+			FProductRequestBatch& Batch = ProductRequestBatches.AddDefaulted_GetRef();
+			Batch.BatchID = ++LastProductRequestBatchID;
+			Batch.StartTime = FPlatformTime::Seconds();
+			Batch.ProductIDs.Append(ProductIDs.GetData() + Offset, FMath::Min(MaxBatchSize, ProductIDs.Num() - Offset));
+
+			DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+				LogMobileStorePurchaseSystem,
+				"Request products batch %i: %i products",
+				Batch.BatchID,
+				Batch.ProductIDs.Num()
+			)
+
+			FBillingFlightRecorder::Get().Record(EBillingFlightEvent::ProductsRequested, FString(), FString(), Batch.ProductIDs.Num());
+
+			const int32 BatchID = Batch.BatchID;
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, BatchID](float)
+			{
+				ExpireProductRequestBatch(BatchID);
+				return false;
+			}), Timeout);
+
+			// Copy, proxy may answer synchronously and modify batches
+			PurchaseInterface->RequestProducts(TArray<FString>(Batch.ProductIDs));
+		}
+
+		UpdateStatCounters();
+		return;
+	}
+	
+	if (PlatformImpl)
+	{
+		// Platform implementation tracks its own requests
+		for(const FString& ProductId : PendingProductIdRequests)
+		{
+			ScheduledProductIds.Remove(ProductId);
+		}
+		
+		PlatformImpl->RequestProducts();
+	}
+}
+
+void UManagerMobileStorePurchase::CompleteProductRequest(const FString& ProductId)
+{
+	if(!ScheduledProductIds.Remove(ProductId)) return;
+
+	for(int32 i = ProductRequestBatches.Num() - 1; i >= 0; --i)
+	{
+		FProductRequestBatch& Batch = ProductRequestBatches[i];
+		if(Batch.ProductIDs.RemoveSingleSwap(ProductId, false) <= 0) continue;
+
+		if(Batch.ProductIDs.Num() <= 0)
+		{
+			DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+				LogMobileStorePurchaseSystem,
+				"Products batch %i completed in %f s",
+				Batch.BatchID,
+				FPlatformTime::Seconds() - Batch.StartTime
+			)
+			
+			ProductRequestBatches.RemoveAtSwap(i, 1, false);
+
+			if(ProductRequestBatches.Num() <= 0)
+			{
+				SaveProductCatalogCache();
+			}
+		}
+		
+		break;
+	}
+}
+
+void UManagerMobileStorePurchase::ExpireProductRequestBatch(int32 BatchID)
+{
+	const int32 BatchIndex = ProductRequestBatches.IndexOfByPredicate([BatchID](const FProductRequestBatch& Batch)
+	{
+		return Batch.BatchID == BatchID;
+	});
+	if(BatchIndex == INDEX_NONE) return;
+
+	const FProductRequestBatch Batch = MoveTemp(ProductRequestBatches[BatchIndex]);
+	ProductRequestBatches.RemoveAtSwap(BatchIndex, 1, false);
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Products batch %i timed out, %i products not received",
+		Batch.BatchID,
+		Batch.ProductIDs.Num()
+	)
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::ProductsTimedOut, FString(), FString(), Batch.ProductIDs.Num());
+
+	// Unanswered ids become requestable again
+	for(const FString& ProductId : Batch.ProductIDs)
+	{
+		ScheduledProductIds.Remove(ProductId);
+	}
+
+	UpdateStatCounters();
+
+	if(ProductRequestBatches.Num() <= 0)
+	{
+		SaveProductCatalogCache();
+	}
+}
+
+void UManagerMobileStorePurchase::UpdateStatCounters() const
+{
+	MOBILE_STORE_PURCHASE_COUNTER_SET(ProductRequests, ScheduledProductIds.Num());
+	MOBILE_STORE_PURCHASE_COUNTER_SET(Purchases, PurchaseTransactions.Num());
+	MOBILE_STORE_PURCHASE_COUNTER_SET(CachedOffers, StoreCatalog.Num());
+}
+
+void UManagerMobileStorePurchase::ReceiveProductInfo(TSharedPtr<FOnlineStoreOffer> ProductInfo)
+{
+	ReceiveProductsInfo({ProductInfo});
+}
+
+void UManagerMobileStorePurchase::ReceiveProductsInfo(const TArray<TSharedPtr<FOnlineStoreOffer>>& ProductsInfo)
+{
+	TArray<FStoreProduct> Products;
+	Products.Reserve(ProductsInfo.Num());
+
+	for(const TSharedPtr<FOnlineStoreOffer>& ProductInfo : ProductsInfo)
+	{
+		if(ProductInfo.IsValid())
+		{
+			Products.Add(FStoreProduct::FromOffer(*ProductInfo));
+		}
+	}
+
+	ReceiveStoreProducts(Products);
+}
+
+void UManagerMobileStorePurchase::ReceiveStoreProducts(const TArray<FStoreProduct>& Products)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(ReceiveProducts);
+
+	TArray<FString> ReceivedProductIDs;
+	ReceivedProductIDs.Reserve(Products.Num());
+	StoreCatalog.Reserve(StoreCatalog.Num() + Products.Num());
+	
+	for(const FStoreProduct& Product : Products)
+	{
+		if(Product.ProductID.IsEmpty()) continue;
+		
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Product info received: %s -- %s",
+			*Product.ProductID,
+			*Product.PriceText
+		);
+		
+		StoreCatalog.Add(Product, true);
+		ReceivedProductIDs.Add(Product.ProductID);
+	}
+
+	if(ReceivedProductIDs.Num() <= 0) return;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::ProductsReceived, FString(), FString(), ReceivedProductIDs.Num());
+	
+	bCatalogCacheDirty = true;
+
+	for(const FString& ProductID : ReceivedProductIDs)
+	{
+		CompleteProductRequest(ProductID);
+	}
+
+	UpdateStatCounters();
+
+	NotifyProductsUpdated(ReceivedProductIDs);
+}
+
+void UManagerMobileStorePurchase::NotifyProductsUpdated(const TArray<FString>& ProductIDs)
+{
+	for(const FString& ProductID : ProductIDs)
+	{
+		TArray<FProductSubscription, TInlineAllocator<1>>* Subscriptions = ProductSubscriptions.Find(ProductID);
+		if(!Subscriptions) continue;
+
+		// Copy, subscribers usually unsubscribe from inside the callback
+		const TArray<FProductSubscription, TInlineAllocator<1>> SubscriptionsCopy = *Subscriptions;
+		for(const FProductSubscription& Subscription : SubscriptionsCopy)
+		{
+			Subscription.Delegate.ExecuteIfBound(ProductID);
+		}
+
+		if(TArray<FProductSubscription, TInlineAllocator<1>>* RemainingSubscriptions = ProductSubscriptions.Find(ProductID))
+		{
+			RemainingSubscriptions->RemoveAllSwap([](const FProductSubscription& Subscription)
+			{
+				return !Subscription.Delegate.IsBound();
+			});
+
+			if(RemainingSubscriptions->Num() <= 0)
+			{
+				ProductSubscriptions.Remove(ProductID);
+			}
+		}
+	}
+
+	OnProductsBatchReceived.Broadcast(ProductIDs);
+	OnProductsReceived.Broadcast();
+}
+
+FDelegateHandle UManagerMobileStorePurchase::SubscribeToProduct(const FString& ProductId, FShopProductUpdateDelegate Delegate)
+{
+	if(!Delegate.IsBound()) return FDelegateHandle();
+
+	FProductSubscription& Subscription = ProductSubscriptions.FindOrAdd(ProductId).AddDefaulted_GetRef();
+	Subscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	Subscription.Delegate = MoveTemp(Delegate);
+
+	return Subscription.Handle;
+}
+
+void UManagerMobileStorePurchase::UnsubscribeFromProduct(const FString& ProductId, FDelegateHandle Handle)
+{
+	TArray<FProductSubscription, TInlineAllocator<1>>* Subscriptions = ProductSubscriptions.Find(ProductId);
+	if(!Subscriptions) return;
+
+	Subscriptions->RemoveAllSwap([Handle](const FProductSubscription& Subscription)
+	{
+		return Subscription.Handle == Handle || !Subscription.Delegate.IsBound();
+	});
+
+	if(Subscriptions->Num() <= 0)
+	{
+		ProductSubscriptions.Remove(ProductId);
+	}
+}
+
+void UManagerMobileStorePurchase::ProcessPurchase(FPurchaseInfoRaw PurchaseInfo)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(ProcessPurchase);
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Process purchase in manager: %s",
+		*PurchaseInfo.ProductID
+	);
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseDelivered, PurchaseInfo.ProductID, PurchaseInfo.TransactionID);
+	
+	const FString& TransactionID = PurchaseInfo.TransactionID;
+
+	// Content is applied already, only last finalize failed
+	if(const FPurchaseReceiptInfo* GrantedReceipt = GrantedTransactions.Find(TransactionID))
+	{
+		if(!FinalizedTransactionIDs.Contains(TransactionID))
+		{
+			DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+				LogMobileStorePurchaseSystem,
+				"Granted purchase redelivered, finalizing again: %s",
+				*TransactionID
+			)
+			
+			FinalizePurchase(*GrantedReceipt);
+		}
+
+		return;
+	}
+	
+	if(!TransactionID.IsEmpty() && (FinalizedTransactionIDs.Contains(TransactionID) || PurchaseRequestIDs.Contains(TransactionID) || VerifyingTransactionIDs.Contains(TransactionID)))
+	{
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Repeated purchase delivery ignored: %s",
+			*TransactionID
+		)
+		
+		return;
+	}
+	
+	FPurchaseReceiptInfo PurchaseReceiptInfo;
+	PurchaseReceiptInfo.ProductID = PurchaseInfo.ProductID;
+	PurchaseReceiptInfo.TransactionID = TransactionID;
+	PurchaseReceiptInfo.CustomData = PurchaseInfo.CustomData;
+
+	// Android purchases come resolved from worker thread
+	PurchaseReceiptInfo.ShopItemData = PurchaseInfo.ShopItemData.Get();
+	if(!PurchaseReceiptInfo.ShopItemData)
+	{
+		PurchaseReceiptInfo.ShopItemData = ResolveShopItemByProductId(PurchaseInfo.ProductID);
+	}
+
+	// Not paid yet, so nothing is journaled, granted or finalized. Store delivers it again once paid
+	if(IsPendingPurchase(PurchaseInfo))
+	{
+		ProcessPendingPurchase(PurchaseInfo, PurchaseReceiptInfo);
+
+		return;
+	}
+
+	if(PurchaseJournal)
+	{
+		// Content was granted, but store did not take finalize, so only finalize again
+		const FPurchaseJournalEntry* JournalEntry = PurchaseJournal->Find(TransactionID);
+		if(JournalEntry && JournalEntry->State == EPurchaseJournalRecord::Granted)
+		{
+			FinalizePurchase(PurchaseReceiptInfo);
+			
+			return;
+		}
+	}
+
+	if(!PurchaseVerifier || !FPurchaseReceiptVerifier::NeedsVerification(PurchaseInfo) || PurchaseVerifier->IsVerified(PurchaseInfo))
+	{
+		AcceptPurchase(PurchaseInfo, PurchaseReceiptInfo);
+
+		return;
+	}
+
+	VerifyingTransactionIDs.Add(TransactionID);
+
+	PurchaseVerifier->Verify(PurchaseInfo, FPurchaseVerifyDelegate::CreateWeakLambda(this, [this, PurchaseInfo, PurchaseReceiptInfo](bool bValid, const FString& Error)
+	{
+		VerifyingTransactionIDs.Remove(PurchaseInfo.TransactionID);
+
+		if(bValid)
+		{
+			AcceptPurchase(PurchaseInfo, PurchaseReceiptInfo);
+		}
+		else
+		{
+			RejectPurchase(PurchaseInfo, Error);
+		}
+	}));
+}
+
+bool UManagerMobileStorePurchase::IsPendingPurchase(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	const FString* PurchaseState = PurchaseInfo.CustomData.Find("PurchaseState");
+	return PurchaseState && *PurchaseState == "2";
+}
+
+void UManagerMobileStorePurchase::ProcessPendingPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FPurchaseReceiptInfo& PurchaseReceiptInfo)
+{
+	const FString& TransactionID = PurchaseInfo.TransactionID;
+
+	// Store repeats pending purchases until they are paid
+	if(!TransactionID.IsEmpty() && PendingPurchaseRequestIDs.Contains(TransactionID)) return;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchasePending, PurchaseInfo.ProductID, TransactionID);
+
+	const int32 RequestID = FindLaunchedPurchaseRequest(PurchaseInfo.ProductID);
+	if(!TransactionID.IsEmpty())
+	{
+		PendingPurchaseRequestIDs.Add(TransactionID, RequestID);
+	}
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase request %i: %s pending payment",
+		RequestID,
+		*PurchaseInfo.ProductID
+	)
+
+	FPurchasePendingDelegate OnPending;
+	if(RequestID != INDEX_NONE)
+	{
+		FPurchaseTransaction& Transaction = PurchaseTransactions.FindChecked(RequestID);
+		Transaction.TransactionID = TransactionID;
+		Transaction.State = EPurchaseTransactionState::Pending;
+
+		OnPending = Transaction.OnPending;
+	}
+
+	OnPending.ExecuteIfBound(PurchaseReceiptInfo);
+	OnPurchasePending.Broadcast(true, PurchaseReceiptInfo);
+}
+
+void UManagerMobileStorePurchase::AcceptPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FPurchaseReceiptInfo& PurchaseReceiptInfo)
+{
+	const FString& TransactionID = PurchaseInfo.TransactionID;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseAccepted, PurchaseInfo.ProductID, TransactionID);
+
+	ResolveRestoredOwnership(TransactionID, true);
+	
+	if(PurchaseJournal)
+	{
+		// Written before anyone grants content, so crash from here on is recovered on next start
+		PurchaseJournal->Record(PurchaseInfo);
+	}
+
+	int32 RequestID = FindPurchaseRequest(PurchaseInfo);
+	const bool bHasRequest = RequestID != INDEX_NONE;
+	if(!bHasRequest)
+	{
+		// Late delivery, like pending purchase approved after its request failed, goes to OnPurchaseComplete and shop item
+		RequestID = ++LastPurchaseRequestID;
+		
+		FPurchaseTransaction& Transaction = PurchaseTransactions.Add(RequestID);
+		Transaction.RequestID = RequestID;
+		Transaction.ProductID = PurchaseInfo.ProductID;
+		Transaction.StartTime = FPlatformTime::Seconds();
+	}
+
+	FPurchaseTransaction& Transaction = PurchaseTransactions.FindChecked(RequestID);
+	Transaction.TransactionID = TransactionID;
+	Transaction.State = EPurchaseTransactionState::Purchased;
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase request %i: %s purchased in %f s",
+		RequestID,
+		*PurchaseInfo.ProductID,
+		FPlatformTime::Seconds() - Transaction.StartTime
+	)
+
+	const FPurchaseCompleteDelegate OnComplete = MoveTemp(Transaction.OnComplete);
+	Transaction.OnComplete.Unbind();
+
+	if(TransactionID.IsEmpty())
+	{
+		// Can't be matched on finalize
+		PurchaseTransactions.Remove(RequestID);
+	}
+	else
+	{
+		PurchaseRequestIDs.Add(TransactionID, RequestID);
+	}
+
+	UpdateStatCounters();
+
+	// Transaction may be finalized and removed from inside callbacks
+	OnComplete.ExecuteIfBound(true, PurchaseReceiptInfo);
+	OnPurchaseComplete.Broadcast(true, PurchaseReceiptInfo);
+
+	if(bHasRequest) return;
+
+	// Granted by OnPurchaseComplete listener
+	const EPurchaseTransactionState State = GetTransactionState(TransactionID);
+	if(State == EPurchaseTransactionState::Granted || State == EPurchaseTransactionState::Finalized) return;
+
+	const TWeakObjectPtr<UShopItemMobileStorePurchase>* ShopItem = ShopItemsByProduct.Find(PurchaseInfo.ProductID);
+	if(ShopItem && ShopItem->IsValid())
+	{
+		(*ShopItem)->GrantRecoveredPurchase(PurchaseReceiptInfo);
+
+		return;
+	}
+
+	UnclaimedPurchases.FindOrAdd(PurchaseInfo.ProductID).Add(PurchaseReceiptInfo);
+}
+
+void UManagerMobileStorePurchase::RejectPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FString& Error)
+{
+	LOG(LogMobileStorePurchaseSystem, "Purchase %s rejected: %s", *PurchaseInfo.ProductID, *Error)
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::PurchaseRejected, PurchaseInfo.ProductID, PurchaseInfo.TransactionID);
+	FBillingFlightRecorder::Get().DumpOnError();
+
+	ResolveRestoredOwnership(PurchaseInfo.TransactionID, false);
+
+	// Not finalized, store refunds unacknowledged purchases by itself
+	const int32 RequestID = FindPurchaseRequest(PurchaseInfo);
+	if(RequestID != INDEX_NONE)
+	{
+		FailPurchaseRequest(RequestID, Error);
+	}
+}
+
+void UManagerMobileStorePurchase::ProcessPurchaseError(FString ProductID, FString Error)
+{
+	const int32 RequestID = FindLaunchedPurchaseRequest(ProductID);
+	if(RequestID != INDEX_NONE)
+	{
+		FailPurchaseRequest(RequestID, Error);
+		
+		return;
+	}
+
+	DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+		LogMobileStorePurchaseSystem,
+		"Purchase error without open request: %s - %s",
+		*ProductID,
+		*Error
+	)
+
+	FPurchaseReceiptInfo PurchaseReceiptInfo;
+	PurchaseReceiptInfo.ProductID = ProductID;
+	OnPurchaseComplete.Broadcast(false, PurchaseReceiptInfo);
 }
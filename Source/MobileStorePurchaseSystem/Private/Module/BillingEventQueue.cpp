@@ -0,0 +1,84 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Module/BillingEventQueue.h"
+
+#include "Module/MobileStorePurchaseStats.h"
+#include "Module/MobileStorePurchaseSystemSettings.h"
+
+FBillingEventQueue::~FBillingEventQueue()
+{
+	Stop();
+}
+
+void FBillingEventQueue::Start()
+{
+	if(TickHandle.IsValid()) return;
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FBillingEventQueue::Tick));
+}
+
+void FBillingEventQueue::Stop()
+{
+	if(TickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
+	}
+
+	// Events hold callbacks into objects that are going away
+	for(TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc>& Queue : Queues)
+	{
+		Queue.Empty();
+	}
+
+	PendingNum.store(0, std::memory_order_relaxed);
+
+	MOBILE_STORE_PURCHASE_COUNTER_SET(QueuedEvents, 0);
+}
+
+void FBillingEventQueue::Enqueue(EBillingEventPriority Priority, TUniqueFunction<void()>&& Event)
+{
+	if(!Event) return;
+
+	PendingNum.fetch_add(1, std::memory_order_relaxed);
+	Queues[static_cast<uint8>(Priority)].Enqueue(MoveTemp(Event));
+}
+
+int32 FBillingEventQueue::Drain(double TimeBudgetSeconds, int32 EventBudget)
+{
+	check(IsInGameThread());
+
+	MOBILE_STORE_PURCHASE_SCOPE(DrainEvents);
+
+	const double EndTime = FPlatformTime::Seconds() + TimeBudgetSeconds;
+	int32 EventsNum = 0;
+
+	for(TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc>& Queue : Queues)
+	{
+		TUniqueFunction<void()> Event;
+		while(Queue.Dequeue(Event))
+		{
+			PendingNum.fetch_sub(1, std::memory_order_relaxed);
+			EventsNum++;
+			
+			Event();
+
+			if(EventsNum >= EventBudget || FPlatformTime::Seconds() >= EndTime) return EventsNum;
+		}
+	}
+
+	return EventsNum;
+}
+
+bool FBillingEventQueue::Tick(float DeltaTime)
+{
+	if(GetPendingNum() <= 0) return true;
+
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	Drain(Settings->BillingEventFrameBudget / 1000.0, Settings->MaxBillingEventsPerFrame);
+
+	// Left for next frames, so growing value means budget is too small
+	MOBILE_STORE_PURCHASE_COUNTER_SET(QueuedEvents, GetPendingNum());
+
+	return true;
+}
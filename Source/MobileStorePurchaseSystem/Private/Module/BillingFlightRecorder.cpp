@@ -0,0 +1,269 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Module/BillingFlightRecorder.h"
+
+#include "LogSystem.h"
+#include "Async/Async.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Module/MobileStorePurchaseSystemSettings.h"
+
+// Available in all builds, shipping has no other billing history
+static FAutoConsoleCommand MobileStorePurchaseDumpFlightRecorderCommand(
+	TEXT("MobileStorePurchase.DumpFlightRecorder"),
+	TEXT("Prints recorded billing events to log. Arguments: optional file path to write them to instead"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if(Args.Num() > 0)
+		{
+			FBillingFlightRecorder::Get().DumpToFile(Args[0]);
+			return;
+		}
+
+		FBillingFlightRecorder::Get().DumpToLog();
+	})
+);
+
+FBillingFlightRecorder& FBillingFlightRecorder::Get()
+{
+	static FBillingFlightRecorder Recorder;
+	return Recorder;
+}
+
+FBillingFlightRecorder::FBillingFlightRecorder()
+{
+	const UMobileStorePurchaseSystemSettings* Settings = GetDefault<UMobileStorePurchaseSystemSettings>();
+	const uint32 Capacity = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(Settings ? Settings->FlightRecorderCapacity : 4096, 64)));
+
+	Slots = MakeUnique<FSlot[]>(Capacity);
+	Mask = Capacity - 1;
+
+	ProductSlots = MakeUnique<FProductSlot[]>(MaxProducts);
+}
+
+void FBillingFlightRecorder::Record(EBillingFlightEvent Event, const FString& ProductID, const FString& TransactionID, int32 Result)
+{
+	FBillingFlightRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.TransactionHandle = GetTransactionHandle(TransactionID);
+	Record.Result = Result;
+	Record.ProductHandle = InternProduct(ProductID);
+	Record.Event = Event;
+
+	const uint64 Index = WriteIndex.fetch_add(1, std::memory_order_relaxed);
+	FSlot& Slot = Slots[Index & Mask];
+
+	Slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.Record = Record;
+
+	Slot.Sequence.store(Index + 1, std::memory_order_release);
+}
+
+TArray<FBillingFlightRecord> FBillingFlightRecorder::Snapshot() const
+{
+	const uint64 EndIndex = WriteIndex.load(std::memory_order_acquire);
+	const uint64 StartIndex = EndIndex > Mask + 1 ? EndIndex - (Mask + 1) : 0;
+
+	TArray<FBillingFlightRecord> Records;
+	Records.Reserve(static_cast<int32>(EndIndex - StartIndex));
+
+	for(uint64 Index = StartIndex; Index < EndIndex; ++Index)
+	{
+		FBillingFlightRecord Record;
+		if(ReadRecord(Index, Record))
+		{
+			Records.Add(Record);
+		}
+	}
+
+	return Records;
+}
+
+bool FBillingFlightRecorder::ReadRecord(uint64 Index, FBillingFlightRecord& OutRecord) const
+{
+	const FSlot& Slot = Slots[Index & Mask];
+
+	const uint64 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+	if(Sequence != Index + 1) return false;
+
+	OutRecord = Slot.Record;
+
+	// Overwritten while copied
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Sequence;
+}
+
+FString FBillingFlightRecorder::Dump() const
+{
+	const TArray<FBillingFlightRecord> Records = Snapshot();
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	FString Text = FString::Printf(TEXT("Billing flight recorder: %i events, newest last\n"), Records.Num());
+	Text.Reserve(Records.Num() * 96);
+
+	for(const FBillingFlightRecord& Record : Records)
+	{
+		Text += FString::Printf(TEXT("-%.6fs %s product=%s transaction=%08x result=%i\n"),
+			FPlatformTime::ToSeconds64(NowCycles - Record.Cycles),
+			GetEventName(Record.Event),
+			GetProductName(Record.ProductHandle),
+			Record.TransactionHandle,
+			Record.Result
+		);
+	}
+
+	return Text;
+}
+
+void FBillingFlightRecorder::DumpToLog() const
+{
+	TArray<FString> Lines;
+	Dump().ParseIntoArrayLines(Lines);
+
+	for(const FString& Line : Lines)
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "%s", *Line)
+	}
+}
+
+void FBillingFlightRecorder::DumpOnCrash() const
+{
+	const uint64 EndIndex = WriteIndex.load(std::memory_order_acquire);
+	const uint64 StartIndex = EndIndex > Mask + 1 ? EndIndex - (Mask + 1) : 0;
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	TCHAR Line[256];
+
+	FCString::Snprintf(Line, UE_ARRAY_COUNT(Line), TEXT("Billing flight recorder: %i events, newest last\n"), static_cast<int32>(EndIndex - StartIndex));
+	FPlatformMisc::LowLevelOutputDebugString(Line);
+
+	for(uint64 Index = StartIndex; Index < EndIndex; ++Index)
+	{
+		FBillingFlightRecord Record;
+		if(!ReadRecord(Index, Record)) continue;
+
+		FCString::Snprintf(Line, UE_ARRAY_COUNT(Line), TEXT("-%.6fs %s product=%s transaction=%08x result=%i\n"),
+			FPlatformTime::ToSeconds64(NowCycles - Record.Cycles),
+			GetEventName(Record.Event),
+			GetProductName(Record.ProductHandle),
+			Record.TransactionHandle,
+			Record.Result
+		);
+		FPlatformMisc::LowLevelOutputDebugString(Line);
+	}
+}
+
+void FBillingFlightRecorder::DumpToFile(const FString& Path) const
+{
+	Async(EAsyncExecution::ThreadPool, [Text = Dump(), Path]()
+	{
+		static FCriticalSection WriteLock;
+		FScopeLock Lock(&WriteLock);
+
+		FFileHelper::SaveStringToFile(Text, *Path);
+	});
+}
+
+void FBillingFlightRecorder::DumpOnError() const
+{
+	if(!GetDefault<UMobileStorePurchaseSystemSettings>()->bDumpFlightRecorderOnError) return;
+
+	DumpToFile(GetDumpPath());
+}
+
+FString FBillingFlightRecorder::GetDumpPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("MobileStorePurchase") / TEXT("FlightRecorder.txt");
+}
+
+const TCHAR* FBillingFlightRecorder::GetEventName(EBillingFlightEvent Event)
+{
+	switch(Event)
+	{
+	case EBillingFlightEvent::ProductsRequested: return TEXT("ProductsRequested");
+	case EBillingFlightEvent::ProductsReceived: return TEXT("ProductsReceived");
+	case EBillingFlightEvent::ProductsTimedOut: return TEXT("ProductsTimedOut");
+	case EBillingFlightEvent::PurchaseStarted: return TEXT("PurchaseStarted");
+	case EBillingFlightEvent::PurchaseDelivered: return TEXT("PurchaseDelivered");
+	case EBillingFlightEvent::PurchasePending: return TEXT("PurchasePending");
+	case EBillingFlightEvent::PurchaseAccepted: return TEXT("PurchaseAccepted");
+	case EBillingFlightEvent::PurchaseRejected: return TEXT("PurchaseRejected");
+	case EBillingFlightEvent::PurchaseFailed: return TEXT("PurchaseFailed");
+	case EBillingFlightEvent::PurchaseGranted: return TEXT("PurchaseGranted");
+	case EBillingFlightEvent::FinalizeRequested: return TEXT("FinalizeRequested");
+	case EBillingFlightEvent::FinalizeResult: return TEXT("FinalizeResult");
+	case EBillingFlightEvent::RestoreStarted: return TEXT("RestoreStarted");
+	case EBillingFlightEvent::RestoreComplete: return TEXT("RestoreComplete");
+	case EBillingFlightEvent::JniProductsCallback: return TEXT("JniProductsCallback");
+	case EBillingFlightEvent::JniPurchaseCallback: return TEXT("JniPurchaseCallback");
+	case EBillingFlightEvent::JniPurchaseErrorCallback: return TEXT("JniPurchaseErrorCallback");
+	case EBillingFlightEvent::JniFinalizeCallback: return TEXT("JniFinalizeCallback");
+	case EBillingFlightEvent::JniRestoreCallback: return TEXT("JniRestoreCallback");
+	case EBillingFlightEvent::JniRestoreCompleteCallback: return TEXT("JniRestoreCompleteCallback");
+	case EBillingFlightEvent::BillingConnecting: return TEXT("BillingConnecting");
+	case EBillingFlightEvent::BillingConnected: return TEXT("BillingConnected");
+	case EBillingFlightEvent::BillingDisconnected: return TEXT("BillingDisconnected");
+	default: return TEXT("None");
+	}
+}
+
+uint32 FBillingFlightRecorder::GetTransactionHandle(const FString& TransactionID)
+{
+	return TransactionID.IsEmpty() ? 0 : FCrc::StrCrc32(*TransactionID);
+}
+
+void FBillingFlightRecorder::RegisterCrashHook()
+{
+	if(CrashHandle.IsValid()) return;
+
+	// Crash reports carry device log, so last billing events end up next to the callstack
+	CrashHandle = FCoreDelegates::OnHandleSystemError.AddRaw(this, &FBillingFlightRecorder::DumpOnCrash);
+}
+
+void FBillingFlightRecorder::UnregisterCrashHook()
+{
+	FCoreDelegates::OnHandleSystemError.Remove(CrashHandle);
+	CrashHandle.Reset();
+}
+
+uint16 FBillingFlightRecorder::InternProduct(const FString& ProductID)
+{
+	if(ProductID.IsEmpty()) return 0;
+
+	// 0 marks free slot. Products with colliding hashes share a slot, fine for diagnostics
+	const uint32 Hash = FCrc::StrCrc32(*ProductID) | 1;
+
+	for(uint32 Probe = 0; Probe < MaxProducts; ++Probe)
+	{
+		const uint32 SlotIndex = (Hash + Probe) & (MaxProducts - 1);
+		FProductSlot& Slot = ProductSlots[SlotIndex];
+
+		uint32 SlotHash = Slot.Hash.load(std::memory_order_acquire);
+		if(SlotHash == 0 && Slot.Hash.compare_exchange_strong(SlotHash, Hash, std::memory_order_acq_rel))
+		{
+			FCString::Strncpy(Slot.Name, *ProductID, MaxProductIDLength);
+			Slot.bNameReady.store(true, std::memory_order_release);
+
+			return static_cast<uint16>(SlotIndex + 1);
+		}
+
+		// Failed exchange leaves hash of the thread that claimed slot
+		if(SlotHash == Hash) return static_cast<uint16>(SlotIndex + 1);
+	}
+
+	// Table is full, product is recorded as unknown
+	return 0;
+}
+
+const TCHAR* FBillingFlightRecorder::GetProductName(uint16 ProductHandle) const
+{
+	if(ProductHandle == 0 || ProductHandle > MaxProducts) return TEXT("");
+
+	// Name of just claimed slot may still be copied
+	const FProductSlot& Slot = ProductSlots[ProductHandle - 1];
+	return Slot.bNameReady.load(std::memory_order_acquire) ? Slot.Name : TEXT("");
+}
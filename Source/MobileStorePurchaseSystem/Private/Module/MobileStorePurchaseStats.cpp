@@ -0,0 +1,25 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Module/MobileStorePurchaseStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(MobileStorePurchaseChannel);
+
+DEFINE_STAT(STAT_MobileStorePurchase_RequestProducts);
+DEFINE_STAT(STAT_MobileStorePurchase_ReceiveProducts);
+DEFINE_STAT(STAT_MobileStorePurchase_JniCall);
+DEFINE_STAT(STAT_MobileStorePurchase_JniCallback);
+DEFINE_STAT(STAT_MobileStorePurchase_DecodeCallback);
+DEFINE_STAT(STAT_MobileStorePurchase_DrainEvents);
+DEFINE_STAT(STAT_MobileStorePurchase_ProcessPurchase);
+DEFINE_STAT(STAT_MobileStorePurchase_FindShopItem);
+DEFINE_STAT(STAT_MobileStorePurchase_FinalizePurchase);
+
+DEFINE_STAT(STAT_MobileStorePurchase_ProductRequests);
+DEFINE_STAT(STAT_MobileStorePurchase_Purchases);
+DEFINE_STAT(STAT_MobileStorePurchase_CachedOffers);
+DEFINE_STAT(STAT_MobileStorePurchase_QueuedEvents);
+
+TRACE_DECLARE_INT_COUNTER(MobileStorePurchase_ProductRequests, TEXT("MobileStorePurchase/ProductRequestsInFlight"));
+TRACE_DECLARE_INT_COUNTER(MobileStorePurchase_Purchases, TEXT("MobileStorePurchase/PurchasesInFlight"));
+TRACE_DECLARE_INT_COUNTER(MobileStorePurchase_CachedOffers, TEXT("MobileStorePurchase/CachedOffers"));
+TRACE_DECLARE_INT_COUNTER(MobileStorePurchase_QueuedEvents, TEXT("MobileStorePurchase/QueuedBillingEvents"));
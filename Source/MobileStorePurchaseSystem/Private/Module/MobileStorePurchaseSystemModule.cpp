@@ -2,6 +2,7 @@
 
 #include "Module/MobileStorePurchaseSystemModule.h"
 
+#include "Module/BillingFlightRecorder.h"
 #include "Module/MobileStorePurchaseSystemSettings.h"
 
 #if UE_EDITOR
@@ -10,6 +11,7 @@
 #endif
 
 #if PLATFORM_ANDROID
+#include "Proxies/AndroidBillingBridge.h"
 #include "Proxies/AndroidBillingHelper.h"
 #endif
 
@@ -23,9 +25,14 @@ void FMobileStorePurchaseSystemModule::StartupModule()
 	RegisterSystemSettings();
 #endif
 
+	BillingEventQueue.Start();
+	FBillingFlightRecorder::Get().RegisterCrashHook();
+
 #if PLATFORM_ANDROID
 	AndroidBillingHelper = NewObject<UAndroidBillingHelper>(GetTransientPackage());
 	AndroidBillingHelper->AddToRoot();
+
+	FAndroidBillingBridge::Get().Initialize();
 #endif
 }
 
@@ -34,6 +41,13 @@ void FMobileStorePurchaseSystemModule::ShutdownModule()
 #if UE_EDITOR
 	UnregisterSystemSettings();
 #endif
+
+#if PLATFORM_ANDROID
+	FAndroidBillingBridge::Get().Shutdown();
+#endif
+
+	BillingEventQueue.Stop();
+	FBillingFlightRecorder::Get().UnregisterCrashHook();
 }
 
 #if UE_EDITOR
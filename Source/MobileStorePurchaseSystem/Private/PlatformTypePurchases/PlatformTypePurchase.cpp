@@ -26,7 +26,7 @@ TArray<FString>& IPlatformTypePurchase::GetProductIdRequestsInProgress() const
 	return Manager->ProductIdRequestsInProgress;
 }
 
-TMap<FString, TSharedPtr<FOnlineStoreOffer>>& IPlatformTypePurchase::GetStoreProducts() const
+FStoreCatalog& IPlatformTypePurchase::GetStoreCatalog() const
 {
-	return Manager->StoreProducts;
+	return Manager->StoreCatalog;
 }
@@ -0,0 +1,731 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Proxies/AndroidBillingBridge.h"
+
+#include "LogSystem.h"
+#include "Module/BillingFlightRecorder.h"
+#include "Module/MobileStorePurchaseStats.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Proxies/AndroidBillingHelper.h"
+#include "Proxies/PurchaseDecoder.h"
+
+#if PLATFORM_ANDROID
+
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Android/AndroidJavaEnv.h"
+#include "Android/AndroidApplication.h"
+#include "Tasks/Pipe.h"
+
+namespace AndroidBilling
+{
+	// JNI local frame size used while reading product arrays
+	constexpr int LocalFrameSize = 16;
+
+	static void SendToGameThread(EBillingEventPriority Priority, TUniqueFunction<void()>&& Event)
+	{
+		FMobileStorePurchaseSystemModule::Get().GetBillingEventQueue().Enqueue(Priority, MoveTemp(Event));
+	}
+
+	// Purchases and purchase errors go through one pipe, so they reach game thread in store order
+	static UE::Tasks::FPipe& GetPurchasePipe()
+	{
+		static UE::Tasks::FPipe PurchasePipe(TEXT("AndroidBillingPurchase"));
+		return PurchasePipe;
+	}
+
+	// Billing thread only copies java strings, decoding and normalization run on task workers
+	static void DecodePurchaseOnWorker(TUniqueFunction<bool(FAndroidPurchaseInfo&)>&& Decode)
+	{
+		GetPurchasePipe().Launch(TEXT("DecodePurchase"), [Decode = MoveTemp(Decode)]() mutable
+		{
+			MOBILE_STORE_PURCHASE_SCOPE(DecodeCallback);
+
+			FAndroidPurchaseInfo AndroidPurchaseInfo;
+			if(!Decode(AndroidPurchaseInfo))
+			{
+				SendToGameThread(EBillingEventPriority::Purchase, []()
+				{
+					if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+					{
+						Billing->OnPurchaseFail.Broadcast("", "Purchase JSON deserialization fail");
+					}
+				});
+				
+				return;
+			}
+
+			FPurchaseInfoRaw PurchaseInfo = FPurchaseDecoder::Get().MakePurchaseInfo(AndroidPurchaseInfo);
+
+			SendToGameThread(EBillingEventPriority::Purchase, [AndroidPurchaseInfo = MoveTemp(AndroidPurchaseInfo), PurchaseInfo = MoveTemp(PurchaseInfo)]()
+			{
+				UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
+				if(!Billing) return;
+				
+				Billing->OnPurchaseDecoded.Broadcast(PurchaseInfo);
+				Billing->OnPurchaseSuccess.Broadcast(AndroidPurchaseInfo);
+			});
+		});
+	}
+
+	static void SendProductsToGameThread(TArray<FAndroidProductInfo>&& ProductsInfo)
+	{
+		BILLING_LOG_STATIC(LogMobileStorePurchaseSystem, "Send %i Products To Unreal", ProductsInfo.Num())
+		
+		SendToGameThread(EBillingEventPriority::Catalog, [ProductsInfo = MoveTemp(ProductsInfo)]()
+		{
+			UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
+			if(!Billing) return;
+
+			Billing->OnProductsInfoReceive.Broadcast(ProductsInfo);
+
+			if(Billing->OnProductInfoReceive.IsBound())
+			{
+				for(const FAndroidProductInfo& ProductInfo : ProductsInfo)
+				{
+					Billing->OnProductInfoReceive.Broadcast(ProductInfo);
+				}
+			}
+		});
+	}
+
+	static FString GetStringElement(JNIEnv* Env, jobjectArray Array, int Index)
+	{
+		jstring Element = (jstring)Env->GetObjectArrayElement(Array, Index);
+		return Element ? FJavaHelper::FStringFromParam(Env, Element) : FString();
+	}
+
+	// Restore parts are decoded in order, so completion can't overtake last part
+	static UE::Tasks::FPipe& GetRestorePipe()
+	{
+		static UE::Tasks::FPipe RestorePipe(TEXT("AndroidBillingRestore"));
+		return RestorePipe;
+	}
+}
+
+static void OnProductsPurchaseSuccessfulFields(JNIEnv *env, jclass clazz,
+	jstring productId, jstring purchaseToken, jstring orderId, jstring signature,
+	jlong purchaseTime, jint quantity, jint purchaseState, jboolean acknowledged, jstring originalJson)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::PurchaseCallback);
+
+	FString ProductID = FJavaHelper::FStringFromParam(env, productId);
+	FString Token = FJavaHelper::FStringFromParam(env, purchaseToken);
+	FString OrderID = FJavaHelper::FStringFromParam(env, orderId);
+	FString Signature = FJavaHelper::FStringFromParam(env, signature);
+	FString OriginalJson = FJavaHelper::FStringFromParam(env, originalJson);
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniPurchaseCallback, ProductID, Token, purchaseState);
+
+	AndroidBilling::DecodePurchaseOnWorker([ProductID = MoveTemp(ProductID), Token = MoveTemp(Token), OrderID = MoveTemp(OrderID),
+		Signature = MoveTemp(Signature), OriginalJson = MoveTemp(OriginalJson), PurchaseTime = (int64)purchaseTime,
+		Quantity = (int32)quantity, PurchaseState = (int32)purchaseState, bAcknowledged = acknowledged == JNI_TRUE](FAndroidPurchaseInfo& PurchaseInfo) mutable
+	{
+		PurchaseInfo.ProductID = MoveTemp(ProductID);
+		PurchaseInfo.Token = MoveTemp(Token);
+		PurchaseInfo.OrderID = MoveTemp(OrderID);
+		PurchaseInfo.Signature = MoveTemp(Signature);
+		PurchaseInfo.Details.Add("PurchaseTime", FString::Printf(TEXT("%lld"), PurchaseTime));
+		PurchaseInfo.Details.Add("Quantity", FString::FromInt(Quantity));
+		PurchaseInfo.Details.Add("PurchaseState", FString::FromInt(PurchaseState));
+		PurchaseInfo.Details.Add("Acknowledged", bAcknowledged ? "True" : "False");
+		PurchaseInfo.Details.Add("OriginalJson", MoveTemp(OriginalJson));
+
+		return true;
+	});
+}
+
+static void OnProductsPurchaseSuccessful(JNIEnv *env, jclass clazz, jstring purchaseJSON, jstring signature)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::PurchaseCallback);
+
+	BILLING_LOG_STATIC(LogMobileStorePurchaseSystem, "UE Billing Product Purchased")
+	
+	FString JSONString = FJavaHelper::FStringFromParam(env, purchaseJSON);
+	FString Signature = FJavaHelper::FStringFromParam(env, signature);
+
+	// Product and token are known only after decoding
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniPurchaseCallback);
+
+	AndroidBilling::DecodePurchaseOnWorker([JSONString = MoveTemp(JSONString), Signature = MoveTemp(Signature)](FAndroidPurchaseInfo& PurchaseInfo)
+	{
+		return FPurchaseDecoder::ParseGooglePlayPurchase(JSONString, Signature, PurchaseInfo);
+	});
+}
+
+static void OnProductsPurchaseError(JNIEnv *env, jclass clazz, jstring productId, jstring Error)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::PurchaseErrorCallback);
+
+	const FString ProductID = FJavaHelper::FStringFromParam(env, productId);
+	const FString ErrorString = FJavaHelper::FStringFromParam(env, Error);
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniPurchaseErrorCallback, ProductID);
+
+	// Must not overtake purchase still being decoded
+	AndroidBilling::GetPurchasePipe().Launch(TEXT("PurchaseError"), [ProductID, ErrorString]()
+	{
+		AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [ProductID, ErrorString]()
+		{
+			if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+			{
+				Billing->OnPurchaseFail.Broadcast(ProductID, ErrorString);
+			}
+		});
+	});
+}
+
+static void OnProductsQuery(JNIEnv *env, jclass clazz, jobjectArray productsDataJSON)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::ProductsCallback);
+
+	if(!env) return;
+		
+	const int ProductsNum = env->GetArrayLength(productsDataJSON);
+
+	BILLING_LOG_STATIC(LogMobileStorePurchaseSystem, "Recieved Products: %i", ProductsNum)
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniProductsCallback, FString(), FString(), ProductsNum);
+		
+	if(ProductsNum <= 0) return;
+
+	// Products are parsed in chunks inside own local frames, so big catalogs can't overflow local reference table
+	constexpr int LocalFrameSize = AndroidBilling::LocalFrameSize;
+
+	TArray<FAndroidProductInfo> ProductsInfo;
+	ProductsInfo.Reserve(ProductsNum);
+		
+	for (int ChunkStart = 0; ChunkStart < ProductsNum; ChunkStart += LocalFrameSize)
+	{
+		if(env->PushLocalFrame(LocalFrameSize) != JNI_OK) break;
+
+		const int ChunkEnd = FMath::Min(ChunkStart + LocalFrameSize, ProductsNum);
+		for (int i = ChunkStart; i < ChunkEnd; ++i)
+		{
+			jstring objKey = (jstring) env->GetObjectArrayElement(productsDataJSON, i);
+			if(!objKey) continue;
+
+			const FString JSONString = FJavaHelper::FStringFromParam(env, objKey);
+
+			TSharedPtr<FJsonObject> MyJson = MakeShareable(new FJsonObject);
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JSONString);
+
+			if (FJsonSerializer::Deserialize(Reader, MyJson))
+			{
+				FAndroidProductInfo& ProductInfo = ProductsInfo.AddDefaulted_GetRef();
+
+				ProductInfo.ProductID = MyJson->GetStringField("ProducID");
+				ProductInfo.Name = MyJson->GetStringField("Name");
+				ProductInfo.Description = MyJson->GetStringField("Description");
+				ProductInfo.Type = MyJson->GetStringField("ProducType");
+				ProductInfo.CurrencyCode = MyJson->GetStringField("CurrencyCode");
+				ProductInfo.FormattedPrice = MyJson->GetStringField("FormattedPrice");
+				// Micros overflow int32 from about 2147 of currency units
+				MyJson->TryGetNumberField("Price", ProductInfo.MicrosPrice);
+			}
+		}
+
+		env->PopLocalFrame(nullptr);
+	}
+
+	AndroidBilling::SendProductsToGameThread(MoveTemp(ProductsInfo));
+}
+
+static void OnProductsQueryFields(JNIEnv *env, jclass clazz,
+	jobjectArray productIds, jobjectArray productTypes, jobjectArray names, jobjectArray descriptions,
+	jobjectArray formattedPrices, jobjectArray currencyCodes, jlongArray microsPrices)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::ProductsCallback);
+
+	if(!env) return;
+
+	const int ProductsNum = env->GetArrayLength(productIds);
+
+	BILLING_LOG_STATIC(LogMobileStorePurchaseSystem, "Recieved Products: %i", ProductsNum)
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniProductsCallback, FString(), FString(), ProductsNum);
+
+	if(ProductsNum <= 0) return;
+
+	jlong* MicrosPrices = env->GetLongArrayElements(microsPrices, nullptr);
+	if(!MicrosPrices) return;
+
+	TArray<FAndroidProductInfo> ProductsInfo;
+	ProductsInfo.Reserve(ProductsNum);
+
+	// Every product takes six local references, one per string array
+	constexpr int ProductsPerFrame = AndroidBilling::LocalFrameSize;
+	
+	for (int ChunkStart = 0; ChunkStart < ProductsNum; ChunkStart += ProductsPerFrame)
+	{
+		if(env->PushLocalFrame(ProductsPerFrame * 6) != JNI_OK) break;
+
+		const int ChunkEnd = FMath::Min(ChunkStart + ProductsPerFrame, ProductsNum);
+		for (int i = ChunkStart; i < ChunkEnd; ++i)
+		{
+			FAndroidProductInfo& ProductInfo = ProductsInfo.AddDefaulted_GetRef();
+			
+			ProductInfo.ProductID = AndroidBilling::GetStringElement(env, productIds, i);
+			ProductInfo.Type = AndroidBilling::GetStringElement(env, productTypes, i);
+			ProductInfo.Name = AndroidBilling::GetStringElement(env, names, i);
+			ProductInfo.Description = AndroidBilling::GetStringElement(env, descriptions, i);
+			ProductInfo.FormattedPrice = AndroidBilling::GetStringElement(env, formattedPrices, i);
+			ProductInfo.CurrencyCode = AndroidBilling::GetStringElement(env, currencyCodes, i);
+			ProductInfo.MicrosPrice = MicrosPrices[i];
+		}
+
+		env->PopLocalFrame(nullptr);
+	}
+
+	env->ReleaseLongArrayElements(microsPrices, MicrosPrices, JNI_ABORT);
+
+	AndroidBilling::SendProductsToGameThread(MoveTemp(ProductsInfo));
+}
+
+static void OnPurchasesFinalized(JNIEnv *env, jclass clazz, jobjectArray purchaseTokens, jintArray responseCodes)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::FinalizeCallback);
+
+	if(!env) return;
+
+	const int TokensNum = env->GetArrayLength(purchaseTokens);
+	if(TokensNum <= 0 || env->GetArrayLength(responseCodes) != TokensNum) return;
+
+	jint* ResponseCodes = env->GetIntArrayElements(responseCodes, nullptr);
+	if(!ResponseCodes) return;
+
+	TArray<FAndroidFinalizeResult> Results;
+	Results.Reserve(TokensNum);
+
+	for (int ChunkStart = 0; ChunkStart < TokensNum; ChunkStart += AndroidBilling::LocalFrameSize)
+	{
+		if(env->PushLocalFrame(AndroidBilling::LocalFrameSize) != JNI_OK) break;
+
+		const int ChunkEnd = FMath::Min(ChunkStart + AndroidBilling::LocalFrameSize, TokensNum);
+		for (int i = ChunkStart; i < ChunkEnd; ++i)
+		{
+			FAndroidFinalizeResult& Result = Results.AddDefaulted_GetRef();
+			Result.Token = AndroidBilling::GetStringElement(env, purchaseTokens, i);
+			Result.ResponseCode = ResponseCodes[i];
+
+			FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniFinalizeCallback, FString(), Result.Token, Result.ResponseCode);
+		}
+
+		env->PopLocalFrame(nullptr);
+	}
+
+	env->ReleaseIntArrayElements(responseCodes, ResponseCodes, JNI_ABORT);
+
+	AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [Results = MoveTemp(Results)]()
+	{
+		if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+		{
+			Billing->OnPurchasesFinalize.Broadcast(Results);
+		}
+	});
+}
+
+static void OnPurchasesRestored(JNIEnv *env, jclass clazz, jobjectArray purchasesJSON, jobjectArray signatures)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::RestoreCallback);
+
+	if(!env) return;
+
+	const int PurchasesNum = env->GetArrayLength(purchasesJSON);
+	if(PurchasesNum <= 0 || env->GetArrayLength(signatures) != PurchasesNum) return;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniRestoreCallback, FString(), FString(), PurchasesNum);
+
+	TArray<FString> PurchasesJson;
+	TArray<FString> Signatures;
+	PurchasesJson.Reserve(PurchasesNum);
+	Signatures.Reserve(PurchasesNum);
+
+	for (int ChunkStart = 0; ChunkStart < PurchasesNum; ChunkStart += AndroidBilling::LocalFrameSize)
+	{
+		if(env->PushLocalFrame(AndroidBilling::LocalFrameSize * 2) != JNI_OK) break;
+
+		const int ChunkEnd = FMath::Min(ChunkStart + AndroidBilling::LocalFrameSize, PurchasesNum);
+		for (int i = ChunkStart; i < ChunkEnd; ++i)
+		{
+			PurchasesJson.Add(AndroidBilling::GetStringElement(env, purchasesJSON, i));
+			Signatures.Add(AndroidBilling::GetStringElement(env, signatures, i));
+		}
+
+		env->PopLocalFrame(nullptr);
+	}
+
+	AndroidBilling::GetRestorePipe().Launch(TEXT("DecodeRestoredPurchases"), [PurchasesJson = MoveTemp(PurchasesJson), Signatures = MoveTemp(Signatures)]()
+	{
+		MOBILE_STORE_PURCHASE_SCOPE(DecodeCallback);
+
+		TArray<FPurchaseInfoRaw> Purchases;
+		Purchases.Reserve(PurchasesJson.Num());
+
+		for(int32 i = 0; i < PurchasesJson.Num(); ++i)
+		{
+			FAndroidPurchaseInfo AndroidPurchaseInfo;
+			if(FPurchaseDecoder::ParseGooglePlayPurchase(PurchasesJson[i], Signatures[i], AndroidPurchaseInfo))
+			{
+				Purchases.Add(FPurchaseDecoder::Get().MakePurchaseInfo(AndroidPurchaseInfo));
+			}
+		}
+
+		AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [Purchases = MoveTemp(Purchases)]()
+		{
+			if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+			{
+				Billing->OnPurchasesRestoreDecoded.Broadcast(Purchases);
+			}
+		});
+	});
+}
+
+static void OnPurchasesRestoreComplete(JNIEnv *env, jclass clazz, jint responseCode)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+	FAndroidBillingBridge::FScopedCallTimer CallTimer(EAndroidBillingCall::RestoreCallback);
+
+	const int32 ResponseCode = responseCode;
+
+	FBillingFlightRecorder::Get().Record(EBillingFlightEvent::JniRestoreCompleteCallback, FString(), FString(), ResponseCode);
+
+	AndroidBilling::GetRestorePipe().Launch(TEXT("CompleteRestore"), [ResponseCode]()
+	{
+		AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [ResponseCode]()
+		{
+			if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+			{
+				// BillingResponseCode.OK
+				Billing->OnPurchasesRestoreComplete.Broadcast(ResponseCode == 0,
+					ResponseCode == 0 ? FString() : FString::Printf(TEXT("Billing response code %i"), ResponseCode));
+			}
+		});
+	});
+}
+
+static void OnBillingConnectionStateChanged(JNIEnv *env, jclass clazz, jint state, jint responseCode, jlong connectMillis)
+{
+	MOBILE_STORE_PURCHASE_SCOPE(JniCallback);
+
+	const EBillingConnectionState State = static_cast<EBillingConnectionState>(FMath::Clamp<int32>(state, 0, 2));
+	const int32 ResponseCode = responseCode;
+	const float ConnectSeconds = static_cast<float>(connectMillis) / 1000.f;
+
+	switch(State)
+	{
+	case EBillingConnectionState::Connecting:
+		FBillingFlightRecorder::Get().Record(EBillingFlightEvent::BillingConnecting);
+		break;
+	case EBillingConnectionState::Connected:
+		FBillingFlightRecorder::Get().Record(EBillingFlightEvent::BillingConnected, FString(), FString(), static_cast<int32>(connectMillis));
+		break;
+	default:
+		FBillingFlightRecorder::Get().Record(EBillingFlightEvent::BillingDisconnected, FString(), FString(), ResponseCode);
+		break;
+	}
+
+	AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [State, ResponseCode, ConnectSeconds]()
+	{
+		if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+		{
+			Billing->SetConnectionState(State, ResponseCode, ConnectSeconds);
+		}
+	});
+}
+
+static const JNINativeMethod BillingNativeMethods[] =
+{
+	{
+		const_cast<char*>("onProductsQuery"),
+		const_cast<char*>("([Ljava/lang/String;)V"),
+		reinterpret_cast<void*>(&OnProductsQuery)
+	},
+	{
+		const_cast<char*>("onProductsQueryFields"),
+		const_cast<char*>("([Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[J)V"),
+		reinterpret_cast<void*>(&OnProductsQueryFields)
+	},
+	{
+		const_cast<char*>("onProductsPurchaseSuccessful"),
+		const_cast<char*>("(Ljava/lang/String;Ljava/lang/String;)V"),
+		reinterpret_cast<void*>(&OnProductsPurchaseSuccessful)
+	},
+	{
+		const_cast<char*>("onProductsPurchaseSuccessfulFields"),
+		const_cast<char*>("(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;JIIZLjava/lang/String;)V"),
+		reinterpret_cast<void*>(&OnProductsPurchaseSuccessfulFields)
+	},
+	{
+		const_cast<char*>("onProductsPurchaseError"),
+		const_cast<char*>("(Ljava/lang/String;Ljava/lang/String;)V"),
+		reinterpret_cast<void*>(&OnProductsPurchaseError)
+	},
+	{
+		const_cast<char*>("onPurchasesFinalized"),
+		const_cast<char*>("([Ljava/lang/String;[I)V"),
+		reinterpret_cast<void*>(&OnPurchasesFinalized)
+	},
+	{
+		const_cast<char*>("onPurchasesRestored"),
+		const_cast<char*>("([Ljava/lang/String;[Ljava/lang/String;)V"),
+		reinterpret_cast<void*>(&OnPurchasesRestored)
+	},
+	{
+		const_cast<char*>("onPurchasesRestoreComplete"),
+		const_cast<char*>("(I)V"),
+		reinterpret_cast<void*>(&OnPurchasesRestoreComplete)
+	},
+	{
+		const_cast<char*>("onBillingConnectionStateChanged"),
+		const_cast<char*>("(IIJ)V"),
+		reinterpret_cast<void*>(&OnBillingConnectionStateChanged)
+	}
+};
+
+#endif
+
+FAndroidBillingBridge& FAndroidBillingBridge::Get()
+{
+	static FAndroidBillingBridge Bridge;
+	return Bridge;
+}
+
+bool FAndroidBillingBridge::Initialize()
+{
+#if PLATFORM_ANDROID
+	if(bInitialized) return true;
+
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if(!Env) return false;
+
+	if(!BillingClass)
+	{
+		BillingClass = FAndroidApplication::FindJavaClassGlobalRef("com/billing/unreal/UnrealBillingAndroid");
+	}
+	
+	if(!BillingClass)
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "Android billing bridge: UnrealBillingAndroid class not found")
+		return false;
+	}
+
+	QueryProductsMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "queryProducts", "([Ljava/lang/String;ZI)V", false);
+	PurchaseMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "purchase", "(Ljava/lang/String;Z)V", false);
+	FinalizePurchasesMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "finalizePurchases", "([Ljava/lang/String;[Z)V", false);
+	RestorePurchasesMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "restorePurchases", "()V", false);
+	GetConnectionStateMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "getConnectionState", "()I", false);
+	GetLastConnectMillisMethod = FJavaWrapper::FindStaticMethod(Env, BillingClass, "getLastConnectMillis", "()J", false);
+
+	// Without natives store answers are lost, so bridge stays uninitialized and registration is retried on next call
+	const bool bNativesRegistered = Env->RegisterNatives(BillingClass, BillingNativeMethods, UE_ARRAY_COUNT(BillingNativeMethods)) == JNI_OK;
+	if(!bNativesRegistered)
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "Android billing bridge: native callbacks registration failed")
+		Env->ExceptionClear();
+	}
+
+	bInitialized = bNativesRegistered && QueryProductsMethod && PurchaseMethod && FinalizePurchasesMethod && RestorePurchasesMethod;
+
+	// Java may have connected before natives were registered, its callbacks were lost then
+	if(bInitialized)
+	{
+		const EBillingConnectionState State = static_cast<EBillingConnectionState>(FMath::Clamp<int32>(QueryConnectionState(), 0, 2));
+		const float ConnectSeconds = State == EBillingConnectionState::Connected ? static_cast<float>(QueryLastConnectMillis()) / 1000.f : 0.f;
+		
+		AndroidBilling::SendToGameThread(EBillingEventPriority::Purchase, [State, ConnectSeconds]()
+		{
+			if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+			{
+				Billing->SetConnectionState(State, 0, ConnectSeconds);
+			}
+		});
+	}
+
+	return bInitialized;
+#else
+	return false;
+#endif
+}
+
+void FAndroidBillingBridge::Shutdown()
+{
+#if PLATFORM_ANDROID
+	if(BillingClass)
+	{
+		if(JNIEnv* Env = FAndroidApplication::GetJavaEnv())
+		{
+			Env->UnregisterNatives(BillingClass);
+			Env->DeleteGlobalRef(BillingClass);
+		}
+	}
+
+	BillingClass = nullptr;
+	QueryProductsMethod = nullptr;
+	PurchaseMethod = nullptr;
+	FinalizePurchasesMethod = nullptr;
+	RestorePurchasesMethod = nullptr;
+	GetConnectionStateMethod = nullptr;
+	GetLastConnectMillisMethod = nullptr;
+#endif
+
+	bInitialized = false;
+}
+
+void FAndroidBillingBridge::QueryProducts(const TArray<FString>& ProductIDs, bool bUseJsonTransfer, int32 ShardSize)
+{
+#if PLATFORM_ANDROID
+	// Retry in case module started before Java environment was ready
+	if(!Initialize()) return;
+
+	MOBILE_STORE_PURCHASE_SCOPE(JniCall);
+	FScopedCallTimer CallTimer(EAndroidBillingCall::QueryProducts);
+	
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return;
+
+	auto ProductIDArray = NewScopedJavaObject(Env, (jobjectArray)Env->NewObjectArray(ProductIDs.Num(), FJavaWrapper::JavaStringClass, NULL));
+	if (!ProductIDArray) return;
+	
+	for (int32 i = 0; i < ProductIDs.Num(); i++)
+	{
+		auto StringValue = FJavaHelper::ToJavaString(Env, ProductIDs[i]);
+		Env->SetObjectArrayElement(*ProductIDArray, i, *StringValue);
+	}
+
+	Env->CallStaticVoidMethod(BillingClass, QueryProductsMethod, *ProductIDArray, (jboolean)bUseJsonTransfer, (jint)ShardSize);
+#endif
+}
+
+void FAndroidBillingBridge::Purchase(const FString& ProductID, bool bUseJsonTransfer)
+{
+#if PLATFORM_ANDROID
+	if(!Initialize()) return;
+
+	MOBILE_STORE_PURCHASE_SCOPE(JniCall);
+	FScopedCallTimer CallTimer(EAndroidBillingCall::Purchase);
+	
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return;
+
+	auto ProductIDParam = FJavaHelper::ToJavaString(Env, ProductID);
+
+	Env->CallStaticVoidMethod(BillingClass, PurchaseMethod, *ProductIDParam, (jboolean)bUseJsonTransfer);
+#endif
+}
+
+void FAndroidBillingBridge::FinalizePurchase(const FString& PurchaseToken, bool bConsume)
+{
+	FinalizePurchases({PurchaseToken}, {bConsume});
+}
+
+void FAndroidBillingBridge::FinalizePurchases(const TArray<FString>& PurchaseTokens, const TArray<bool>& Consume)
+{
+#if PLATFORM_ANDROID
+	if(PurchaseTokens.Num() <= 0 || PurchaseTokens.Num() != Consume.Num() || !Initialize()) return;
+
+	MOBILE_STORE_PURCHASE_SCOPE(JniCall);
+	FScopedCallTimer CallTimer(EAndroidBillingCall::FinalizePurchase);
+	
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return;
+
+	auto TokensArray = NewScopedJavaObject(Env, (jobjectArray)Env->NewObjectArray(PurchaseTokens.Num(), FJavaWrapper::JavaStringClass, NULL));
+	auto ConsumeArray = NewScopedJavaObject(Env, Env->NewBooleanArray(Consume.Num()));
+	if (!TokensArray || !ConsumeArray) return;
+	
+	for (int32 i = 0; i < PurchaseTokens.Num(); i++)
+	{
+		auto StringValue = FJavaHelper::ToJavaString(Env, PurchaseTokens[i]);
+		Env->SetObjectArrayElement(*TokensArray, i, *StringValue);
+	}
+
+	TArray<jboolean> ConsumeValues;
+	ConsumeValues.Reserve(Consume.Num());
+	for (const bool bConsume : Consume)
+	{
+		ConsumeValues.Add((jboolean)bConsume);
+	}
+	
+	Env->SetBooleanArrayRegion(*ConsumeArray, 0, ConsumeValues.Num(), ConsumeValues.GetData());
+
+	Env->CallStaticVoidMethod(BillingClass, FinalizePurchasesMethod, *TokensArray, *ConsumeArray);
+#endif
+}
+
+void FAndroidBillingBridge::RestorePurchases()
+{
+#if PLATFORM_ANDROID
+	if(!Initialize()) return;
+
+	MOBILE_STORE_PURCHASE_SCOPE(JniCall);
+	FScopedCallTimer CallTimer(EAndroidBillingCall::RestorePurchases);
+	
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return;
+
+	Env->CallStaticVoidMethod(BillingClass, RestorePurchasesMethod);
+#endif
+}
+
+int32 FAndroidBillingBridge::QueryConnectionState()
+{
+#if PLATFORM_ANDROID
+	if(!BillingClass || !GetConnectionStateMethod) return 0;
+
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return 0;
+
+	return Env->CallStaticIntMethod(BillingClass, GetConnectionStateMethod);
+#else
+	return 0;
+#endif
+}
+
+int64 FAndroidBillingBridge::QueryLastConnectMillis()
+{
+#if PLATFORM_ANDROID
+	if(!BillingClass || !GetLastConnectMillisMethod) return 0;
+
+	JNIEnv* Env = FAndroidApplication::GetJavaEnv();
+	if (!Env) return 0;
+
+	return Env->CallStaticLongMethod(BillingClass, GetLastConnectMillisMethod);
+#else
+	return 0;
+#endif
+}
+
+FAndroidBillingCallStats FAndroidBillingBridge::GetCallStats(EAndroidBillingCall Call) const
+{
+	FScopeLock Lock(&CallStatsLock);
+	return CallStats[static_cast<uint8>(Call)];
+}
+
+void FAndroidBillingBridge::ResetCallStats()
+{
+	FScopeLock Lock(&CallStatsLock);
+	for(FAndroidBillingCallStats& Stats : CallStats)
+	{
+		Stats = FAndroidBillingCallStats();
+	}
+}
+
+void FAndroidBillingBridge::RecordCall(EAndroidBillingCall Call, uint64 StartCycles)
+{
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	FScopeLock Lock(&CallStatsLock);
+	
+	FAndroidBillingCallStats& Stats = CallStats[static_cast<uint8>(Call)];
+	Stats.Calls++;
+	Stats.TotalSeconds += Seconds;
+	Stats.LastSeconds = Seconds;
+	Stats.MaxSeconds = FMath::Max(Stats.MaxSeconds, Seconds);
+}
@@ -0,0 +1,92 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Proxies/PurchaseDecoder.h"
+
+#include "Data/ShopItemData.h"
+#include "Dom/JsonObject.h"
+#include "Proxies/AndroidBillingHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FPurchaseDecoder& FPurchaseDecoder::Get()
+{
+	static FPurchaseDecoder Decoder;
+	return Decoder;
+}
+
+void FPurchaseDecoder::SetProductIndex(TMap<FString, TWeakObjectPtr<UShopItemData>>&& InProductIndex)
+{
+	TSharedPtr<const TMap<FString, TWeakObjectPtr<UShopItemData>>, ESPMode::ThreadSafe> NewProductIndex =
+		MakeShared<const TMap<FString, TWeakObjectPtr<UShopItemData>>, ESPMode::ThreadSafe>(MoveTemp(InProductIndex));
+
+	FScopeLock Lock(&ProductIndexLock);
+	ProductIndex = MoveTemp(NewProductIndex);
+}
+
+TWeakObjectPtr<UShopItemData> FPurchaseDecoder::FindShopItem(const FString& ProductID) const
+{
+	TSharedPtr<const TMap<FString, TWeakObjectPtr<UShopItemData>>, ESPMode::ThreadSafe> CurrentProductIndex;
+	{
+		// Lock only guards pointer swap, lookup runs on immutable copy
+		FScopeLock Lock(&ProductIndexLock);
+		CurrentProductIndex = ProductIndex;
+	}
+
+	const TWeakObjectPtr<UShopItemData>* ShopItemData = CurrentProductIndex ? CurrentProductIndex->Find(ProductID) : nullptr;
+	return ShopItemData ? *ShopItemData : nullptr;
+}
+
+FPurchaseInfoRaw FPurchaseDecoder::MakePurchaseInfo(const FAndroidPurchaseInfo& AndroidPurchaseInfo) const
+{
+	FPurchaseInfoRaw PurchaseInfo;
+	PurchaseInfo.ProductID = AndroidPurchaseInfo.ProductID;
+	PurchaseInfo.TransactionID = AndroidPurchaseInfo.Token;
+	PurchaseInfo.ShopItemData = FindShopItem(AndroidPurchaseInfo.ProductID);
+
+	PurchaseInfo.CustomData.Reserve(AndroidPurchaseInfo.Details.Num() + 2);
+	PurchaseInfo.CustomData.Add("Signature", AndroidPurchaseInfo.Signature);
+	PurchaseInfo.CustomData.Add("OrderID", AndroidPurchaseInfo.OrderID);
+
+	for (const TTuple<FString, FString>& Detail : AndroidPurchaseInfo.Details)
+	{
+		PurchaseInfo.CustomData.Add(Detail.Key, Detail.Value);
+	}
+
+	return PurchaseInfo;
+}
+
+bool FPurchaseDecoder::ParseGooglePlayPurchase(const FString& PurchaseJson, const FString& Signature, FAndroidPurchaseInfo& OutPurchaseInfo)
+{
+	// Purchase JSON example:
+	//{ 
+	//	"orderId":"GPA.3386-2124-6888-54771",
+	//	"packageName":"marble.strike.battle.royale",
+	//	"productId":"currency_crystals_1",
+	//	"purchaseTime":1665439535789,
+	//	"purchaseState":0,
+	//	"purchaseToken":"okcconnmngpeffhfokpmpbie.AO-J1OysGrijDGzV6sipVFO-3Nf5WyXkpaFa7XPpMcVEOCzSXFJd6AamXcVDlGhPHsWGcGBD7xUrHcGGWAzrdQsVsz6kJwX_gH1FpAuNA1aY7mquS6m7pXs",
+	//	"quantity":1,
+	//	"acknowledged":false
+	//}
+
+	TSharedPtr<FJsonObject> Json;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(PurchaseJson);
+	if(!FJsonSerializer::Deserialize(Reader, Json) || !Json.IsValid()) return false;
+
+	// Purchase time is milliseconds, does not fit int32
+	int64 PurchaseTime = 0;
+	Json->TryGetNumberField(TEXT("purchaseTime"), PurchaseTime);
+
+	OutPurchaseInfo.ProductID = Json->GetStringField("productId");
+	OutPurchaseInfo.Token = Json->GetStringField("purchaseToken");
+	OutPurchaseInfo.OrderID = Json->GetStringField("orderId");
+	OutPurchaseInfo.Signature = Signature;
+	OutPurchaseInfo.Details.Add("PurchaseTime", FString::Printf(TEXT("%lld"), PurchaseTime));
+	OutPurchaseInfo.Details.Add("Quantity", FString::FromInt(Json->GetIntegerField("quantity")));
+	// JSON marks pending as 4, same values as Purchase.getPurchaseState() are used everywhere: 1 purchased, 2 pending
+	OutPurchaseInfo.Details.Add("PurchaseState", Json->GetIntegerField("purchaseState") == 4 ? "2" : "1");
+	OutPurchaseInfo.Details.Add("Acknowledged", Json->GetBoolField("acknowledged") ? "True" : "False");
+	OutPurchaseInfo.Details.Add("OriginalJson", PurchaseJson);
+
+	return true;
+}
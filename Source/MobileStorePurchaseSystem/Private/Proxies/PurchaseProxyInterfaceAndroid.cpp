@@ -3,9 +3,23 @@
 #include "Proxies/PurchaseProxyInterfaceAndroid.h"
 
 #include "LogSystem.h"
+#include "Module/BillingFlightRecorder.h"
 #include "Module/MobileStorePurchaseSystemModule.h"
 #include "Module/MobileStorePurchaseSystemSettings.h"
 
+void UPurchaseProxyInterfaceAndroid::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if(HasAnyFlags(RF_ClassDefaultObject)) return;
+
+	// Connection changes come without any request, so proxy listens from creation
+	if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+	{
+		Billing->OnConnectionStateChanged.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ProcessConnectionStateChanged);
+	}
+}
+
 void UPurchaseProxyInterfaceAndroid::Purchase(FString ProductID)
 {
 	Super::Purchase(ProductID);
@@ -13,11 +27,14 @@ void UPurchaseProxyInterfaceAndroid::Purchase(FString ProductID)
 	UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
 	if(!Billing)
 	{
-		OnProductPurchaseError.Broadcast("No Billing");
+		OnProductPurchaseError.Broadcast(ProductID, "No Billing");
 		return;
 	}
 
-	Billing->OnPurchaseSuccess.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchase);
+	if(!Billing->OnPurchaseDecoded.IsBoundToObject(this))
+	{
+		Billing->OnPurchaseDecoded.AddUObject(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchase);
+	}
 	Billing->OnPurchaseFail.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchaseFail);
 	
 	UAndroidBillingHelper::Get()->Purchase(ProductID);
@@ -38,23 +55,77 @@ void UPurchaseProxyInterfaceAndroid::RequestProducts(TArray<FString> ProductsID)
 			LogMobileStorePurchaseSystem,
 			"Adnroid Billing Helper Products Request"
 		)
-		Billing->OnProductInfoReceive.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ReceiveProduct);
+		Billing->OnProductsInfoReceive.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ReceiveProducts);
 		Billing->RequestProducts(ProductsID);
 
 		return;
 	}
 
 	LOG(LogMobileStorePurchaseSystem, "Adnroid Billing Helper Products Request Failed")
-	OnProductPurchaseError.Broadcast("No Billing");
+	OnProductPurchaseError.Broadcast(FString(), "No Billing");
+}
+
+void UPurchaseProxyInterfaceAndroid::RestorePurchases()
+{
+	UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
+	if(!Billing)
+	{
+		OnPurchasesRestoreComplete.Broadcast(false, "No Billing");
+		return;
+	}
+
+	if(!Billing->OnPurchasesRestoreDecoded.IsBoundToObject(this))
+	{
+		Billing->OnPurchasesRestoreDecoded.AddUObject(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchasesRestore);
+	}
+	Billing->OnPurchasesRestoreComplete.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchasesRestoreComplete);
+
+	Billing->RestorePurchases();
+}
+
+EBillingConnectionState UPurchaseProxyInterfaceAndroid::GetConnectionState() const
+{
+	const UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
+	return Billing ? Billing->GetConnectionState() : EBillingConnectionState::Disconnected;
+}
+
+void UPurchaseProxyInterfaceAndroid::ProcessConnectionStateChanged(EBillingConnectionState State, int32 ResponseCode, float ConnectSeconds)
+{
+	BILLING_LOG(LogMobileStorePurchaseSystem, "Billing connection %s, response code %i", *UEnum::GetValueAsString(State), ResponseCode)
+
+	OnConnectionStateChanged.Broadcast(State, ConnectSeconds);
+}
+
+void UPurchaseProxyInterfaceAndroid::ProcessPurchasesRestore(const TArray<FPurchaseInfoRaw>& Purchases)
+{
+	OnPurchasesRestored.Broadcast(Purchases);
+}
+
+void UPurchaseProxyInterfaceAndroid::ProcessPurchasesRestoreComplete(bool bSuccess, FString Error)
+{
+	BILLING_LOG(LogMobileStorePurchaseSystem, "Restore purchases complete: %s", bSuccess ? TEXT("success") : *Error)
+	
+	OnPurchasesRestoreComplete.Broadcast(bSuccess, Error);
 }
 
 void UPurchaseProxyInterfaceAndroid::FinalizePurchase(const FPurchaseInfoRaw& PurchaseInfo)
 {
-	Super::FinalizePurchase(PurchaseInfo);
+	FinalizePurchases({PurchaseInfo});
+}
 
-	if(UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get())
+void UPurchaseProxyInterfaceAndroid::FinalizePurchases(const TArray<FPurchaseInfoRaw>& Purchases)
+{
+	UAndroidBillingHelper* Billing = UAndroidBillingHelper::Get();
+	if(!Billing || Purchases.Num() <= 0) return;
+
+	TArray<FAndroidPurchaseInfo> AndroidPurchasesInfo;
+	TArray<bool> Consume;
+	AndroidPurchasesInfo.Reserve(Purchases.Num());
+	Consume.Reserve(Purchases.Num());
+	
+	for(const FPurchaseInfoRaw& PurchaseInfo : Purchases)
 	{
-		FAndroidPurchaseInfo AndroidPurchaseInfo;
+		FAndroidPurchaseInfo& AndroidPurchaseInfo = AndroidPurchasesInfo.AddDefaulted_GetRef();
 
 		AndroidPurchaseInfo.Token = PurchaseInfo.TransactionID;
 		AndroidPurchaseInfo.ProductID = PurchaseInfo.ProductID;
@@ -66,47 +137,67 @@ void UPurchaseProxyInterfaceAndroid::FinalizePurchase(const FPurchaseInfoRaw& Pu
 			AndroidPurchaseInfo.Details.Add(Detail.Key, Detail.Value);
 		}
 
-		const bool Consume = PurchaseInfo.CustomData.FindChecked("FinalizeType") == "Consume";
-		
-		Billing->FinalizePurchase(AndroidPurchaseInfo, Consume);
+		Consume.Add(PurchaseInfo.CustomData.FindChecked("FinalizeType") == "Consume");
 	}
+
+	Billing->OnPurchasesFinalize.AddUniqueDynamic(this, &UPurchaseProxyInterfaceAndroid::ProcessPurchasesFinalize);
+	Billing->FinalizePurchases(AndroidPurchasesInfo, Consume);
 }
 
-void UPurchaseProxyInterfaceAndroid::ProcessPurchase(FAndroidPurchaseInfo PurchaseInfo)
+void UPurchaseProxyInterfaceAndroid::ProcessPurchasesFinalize(const TArray<FAndroidFinalizeResult>& Results)
 {
-	LOG(LogMobileStorePurchaseSystem, "Process purchase: %s", *PurchaseInfo.ProductID)
-	
-	FPurchaseInfoRaw Info;
-	Info.ProductID = PurchaseInfo.ProductID;
-	Info.TransactionID = PurchaseInfo.Token;
-	Info.CustomData.Add("Signature", PurchaseInfo.Signature);
-	Info.CustomData.Add("OrderID", PurchaseInfo.OrderID);
+	// BillingResponseCode values
+	constexpr int32 ResponseOK = 0;
+	constexpr int32 ResponseItemNotOwned = 8;
 	
-	for (const TTuple<FString, FString>& Detail : PurchaseInfo.Details)
+	TArray<FPurchaseFinalizeResult> FinalizeResults;
+	FinalizeResults.Reserve(Results.Num());
+
+	for(const FAndroidFinalizeResult& Result : Results)
 	{
-		Info.CustomData.Add(Detail.Key, Detail.Value);
+		FPurchaseFinalizeResult& FinalizeResult = FinalizeResults.AddDefaulted_GetRef();
+		FinalizeResult.TransactionID = Result.Token;
+
+		// Not owned means purchase was already consumed
+		FinalizeResult.bSuccess = Result.ResponseCode == ResponseOK || Result.ResponseCode == ResponseItemNotOwned;
+		if(!FinalizeResult.bSuccess)
+		{
+			FinalizeResult.Error = FString::Printf(TEXT("Billing response code %i"), Result.ResponseCode);
+		}
 	}
+
+	OnPurchasesFinalized.Broadcast(FinalizeResults);
+}
+
+void UPurchaseProxyInterfaceAndroid::ProcessPurchase(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	BILLING_LOG(LogMobileStorePurchaseSystem, "Process purchase: %s", *PurchaseInfo.ProductID)
 	
-	OnProductPurchased.Broadcast(Info);
+	OnProductPurchased.Broadcast(PurchaseInfo);
 }
 
 void UPurchaseProxyInterfaceAndroid::ProcessPurchaseFail(FString PurchaseID, FString Error)
 {
-	LOG(LogMobileStorePurchaseSystem, "Process purchase failed: %s", *Error)
+	BILLING_LOG(LogMobileStorePurchaseSystem, "Process purchase failed: %s", *Error)
 	
-	OnProductPurchaseError.Broadcast(Error);
+	OnProductPurchaseError.Broadcast(PurchaseID, Error);
 }
 
-void UPurchaseProxyInterfaceAndroid::ReceiveProduct(const FAndroidProductInfo& ProductInfo)
+void UPurchaseProxyInterfaceAndroid::ReceiveProducts(const TArray<FAndroidProductInfo>& ProductsInfo)
 {
-	TSharedPtr<FOnlineStoreOffer> Offer = MakeShareable(new FOnlineStoreOffer);
-	Offer->Title = FText::FromString(ProductInfo.Name);
-	Offer->Description = FText::FromString(ProductInfo.Description);
-	Offer->PriceText = FText::FromString(ProductInfo.FormattedPrice);
-	Offer->NumericPrice = ProductInfo.MicrosPrice;
-	Offer->RegularPrice = ProductInfo.MicrosPrice;
-	Offer->CurrencyCode = ProductInfo.CurrencyCode;
-	Offer->OfferId = ProductInfo.ProductID;
+	TArray<FStoreProduct> Products;
+	Products.Reserve(ProductsInfo.Num());
+
+	for(const FAndroidProductInfo& ProductInfo : ProductsInfo)
+	{
+		FStoreProduct& Product = Products.AddDefaulted_GetRef();
+		Product.ProductID = ProductInfo.ProductID;
+		Product.Title = ProductInfo.Name;
+		Product.Description = ProductInfo.Description;
+		Product.PriceText = ProductInfo.FormattedPrice;
+		Product.CurrencyCode = ProductInfo.CurrencyCode;
+		Product.MicrosPrice = ProductInfo.MicrosPrice;
+	}
 	
-	OnProductReceive.Broadcast(Offer);
-}
\ No newline at end of file
+	OnProductsReceive.Broadcast(Products);
+}
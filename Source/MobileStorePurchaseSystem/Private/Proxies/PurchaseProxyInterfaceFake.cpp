@@ -0,0 +1,307 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Proxies/PurchaseProxyInterfaceFake.h"
+
+#include "LogSystem.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Module/MobileStorePurchaseSystemSettings.h"
+
+void UPurchaseProxyInterfaceFake::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if(RandomSeed != 0)
+	{
+		Random.Initialize(RandomSeed);
+	}
+	else
+	{
+		Random.GenerateNewSeed();
+	}
+}
+
+void UPurchaseProxyInterfaceFake::Purchase(FString ProductID)
+{
+	Super::Purchase(ProductID);
+
+	PurchasesCount++;
+
+	BuildCatalog();
+
+	if(!Catalog.Contains(ProductID) || Roll(PurchaseErrorRate))
+	{
+		const FString Error = Catalog.Contains(ProductID) ? "Fake store purchase error" : "Fake store unknown product";
+		
+		ScheduleWithDuplicates(RollLatency(PurchaseLatency), [this, ProductID, Error]()
+		{
+			OnProductPurchaseError.Broadcast(ProductID, Error);
+		});
+
+		return;
+	}
+
+	FPurchaseInfoRaw PurchaseInfo;
+	PurchaseInfo.ProductID = ProductID;
+	PurchaseInfo.TransactionID = FGuid::NewGuid().ToString(EGuidFormats::Digits);
+	PurchaseInfo.CustomData.Add("OrderID", FString::Printf(TEXT("FAKE.%i"), PurchasesCount));
+	PurchaseInfo.CustomData.Add("Signature", FString());
+	PurchaseInfo.CustomData.Add("PurchaseTime", FString::Printf(TEXT("%lld"), FDateTime::UtcNow().ToUnixTimestamp() * 1000));
+	PurchaseInfo.CustomData.Add("Quantity", "1");
+	PurchaseInfo.CustomData.Add("PurchaseState", "1");
+	PurchaseInfo.CustomData.Add("Acknowledged", "False");
+
+	float Delay = RollLatency(PurchaseLatency);
+	if(Roll(PendingPurchaseRate))
+	{
+		// Order is placed first and paid later, restore reports it as pending meanwhile
+		FPurchaseInfoRaw PendingInfo = PurchaseInfo;
+		PendingInfo.CustomData.Add("PurchaseState", "2");
+
+		ScheduleWithDuplicates(Delay, [this, PendingInfo]()
+		{
+			OwnedPurchases.Add(PendingInfo.TransactionID, PendingInfo);
+			OnProductPurchased.Broadcast(PendingInfo);
+		});
+
+		Delay += RollLatency(PendingPurchaseLatency);
+	}
+
+	ScheduleWithDuplicates(Delay, [this, PurchaseInfo]()
+	{
+		OwnedPurchases.Add(PurchaseInfo.TransactionID, PurchaseInfo);
+		OnProductPurchased.Broadcast(PurchaseInfo);
+	});
+}
+
+void UPurchaseProxyInterfaceFake::RequestProducts(TArray<FString> ProductsID)
+{
+	Super::RequestProducts(ProductsID);
+
+	QueriesCount++;
+
+	BuildCatalog();
+
+	if(Roll(QueryErrorRate))
+	{
+		DEBUG_MESSAGE(GetDefault<UMobileStorePurchaseSystemSettings>()->bShowDebugMessages,
+			LogMobileStorePurchaseSystem,
+			"Fake store query of %i products failed",
+			ProductsID.Num()
+		)
+
+		// Store query errors never reach manager, products have to time out
+		return;
+	}
+
+	TArray<FStoreProduct> Offers;
+	Offers.Reserve(ProductsID.Num());
+
+	for(const FString& ProductID : ProductsID)
+	{
+		if(const FStoreProduct* Offer = Catalog.Find(ProductID))
+		{
+			// Own copy per answer, as real store does
+			Offers.Add(*Offer);
+		}
+	}
+
+	// Shards of a real store query are answered independently, each with own latency
+	const int32 ShardSize = GetDefault<UMobileStorePurchaseSystemSettings>()->ProductQueryShardSize;
+	int32 PartSize = ShardSize > 0 ? ShardSize : FMath::Max(Offers.Num(), 1);
+
+	if(bOutOfOrderCallbacks && Offers.Num() > 1)
+	{
+		for(int32 i = Offers.Num() - 1; i > 0; --i)
+		{
+			Offers.Swap(i, Random.RandRange(0, i));
+		}
+
+		const int32 PartsNum = FMath::Min(Offers.Num(), Random.RandRange(2, 4));
+		PartSize = FMath::Min(PartSize, FMath::DivideAndRoundUp(Offers.Num(), PartsNum));
+	}
+
+	for(int32 Offset = 0; Offset < Offers.Num(); Offset += PartSize)
+	{
+		TArray<FStoreProduct> Part(Offers.GetData() + Offset, FMath::Min(PartSize, Offers.Num() - Offset));
+
+		ScheduleWithDuplicates(RollLatency(QueryLatency), [this, Part = MoveTemp(Part)]()
+		{
+			OnProductsReceive.Broadcast(Part);
+		});
+	}
+}
+
+void UPurchaseProxyInterfaceFake::FinalizePurchase(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	FinalizePurchases({PurchaseInfo});
+}
+
+void UPurchaseProxyInterfaceFake::FinalizePurchases(const TArray<FPurchaseInfoRaw>& Purchases)
+{
+	TArray<FPurchaseFinalizeResult> Results;
+	Results.Reserve(Purchases.Num());
+
+	// Failures are rolled now, so results don't depend on callbacks order
+	TSet<FString> ConsumedTransactions;
+	
+	for(const FPurchaseInfoRaw& PurchaseInfo : Purchases)
+	{
+		FPurchaseFinalizeResult& Result = Results.AddDefaulted_GetRef();
+		Result.TransactionID = PurchaseInfo.TransactionID;
+		Result.bSuccess = !Roll(FinalizeErrorRate);
+		if(!Result.bSuccess)
+		{
+			Result.Error = "Fake store finalize error";
+		}
+
+		const FString* FinalizeType = PurchaseInfo.CustomData.Find("FinalizeType");
+		if(FinalizeType && *FinalizeType == "Consume")
+		{
+			ConsumedTransactions.Add(PurchaseInfo.TransactionID);
+		}
+	}
+	
+	// Requests of one batch run concurrently, batch answers with the slowest one
+	float Delay = 0.f;
+	for(int32 i = 0; i < Purchases.Num(); ++i)
+	{
+		Delay = FMath::Max(Delay, RollLatency(FinalizeLatency));
+	}
+	
+	Schedule(Delay, [this, Results, ConsumedTransactions]()
+	{
+		for(const FPurchaseFinalizeResult& Result : Results)
+		{
+			if(!Result.bSuccess) continue;
+
+			// Consumed purchases are gone from store, acknowledged ones stay owned
+			if(ConsumedTransactions.Contains(Result.TransactionID))
+			{
+				OwnedPurchases.Remove(Result.TransactionID);
+			}
+			else if(FPurchaseInfoRaw* OwnedPurchase = OwnedPurchases.Find(Result.TransactionID))
+			{
+				OwnedPurchase->CustomData.Add("Acknowledged", "True");
+			}
+			
+			bool bAlreadyFinalized = false;
+			FinalizedTransactions.Add(Result.TransactionID, &bAlreadyFinalized);
+
+			if(bAlreadyFinalized)
+			{
+				LOG(LogMobileStorePurchaseSystem, "Fake store transaction finalized twice: %s", *Result.TransactionID)
+				continue;
+			}
+
+			FinalizedCount++;
+		}
+
+		OnPurchasesFinalized.Broadcast(Results);
+	});
+}
+
+void UPurchaseProxyInterfaceFake::RestorePurchases()
+{
+	if(Roll(QueryErrorRate))
+	{
+		Schedule(RollLatency(QueryLatency), [this]()
+		{
+			OnPurchasesRestoreComplete.Broadcast(false, "Fake store restore error");
+		});
+
+		return;
+	}
+	
+	TArray<FPurchaseInfoRaw> Purchases;
+	OwnedPurchases.GenerateValueArray(Purchases);
+
+	// Parts arrive one by one like store query pages
+	float Delay = 0.f;
+	for(int32 PartStart = 0; PartStart < Purchases.Num(); PartStart += RestorePartSize)
+	{
+		Delay += RollLatency(QueryLatency);
+
+		TArray<FPurchaseInfoRaw> Part(Purchases.GetData() + PartStart, FMath::Min(RestorePartSize, Purchases.Num() - PartStart));
+		ScheduleWithDuplicates(Delay, [this, Part]()
+		{
+			OnPurchasesRestored.Broadcast(Part);
+		});
+	}
+
+	Schedule(Delay + RollLatency(QueryLatency), [this]()
+	{
+		OnPurchasesRestoreComplete.Broadcast(true, FString());
+	});
+}
+
+void UPurchaseProxyInterfaceFake::ResetCatalog()
+{
+	Catalog.Empty();
+}
+
+FString UPurchaseProxyInterfaceFake::GetGeneratedProductID(int32 Index) const
+{
+	return FString::Printf(TEXT("%s%i"), *GeneratedProductPrefix, Index);
+}
+
+void UPurchaseProxyInterfaceFake::BuildCatalog()
+{
+	if(Catalog.Num() > 0) return;
+
+	TArray<FString> ProductIDs = GetDefault<UMobileStorePurchaseSystemSettings>()->StoreProductIDs;
+	ProductIDs.Reserve(ProductIDs.Num() + CatalogSize);
+
+	for(int32 i = 0; i < CatalogSize; ++i)
+	{
+		ProductIDs.Add(GetGeneratedProductID(i));
+	}
+
+	Catalog.Reserve(ProductIDs.Num());
+
+	for(const FString& ProductID : ProductIDs)
+	{
+		// Stable price per product, from 0.99 to 99.99
+		const int64 Micros = (static_cast<int64>(GetTypeHash(ProductID) % 100) * 1000000) + 990000;
+
+		FStoreProduct Product;
+		Product.ProductID = ProductID;
+		Product.Title = ProductID;
+		Product.Description = FString::Printf(TEXT("Fake store product %s"), *ProductID);
+		Product.MicrosPrice = Micros;
+		Product.CurrencyCode = CurrencyCode;
+		Product.PriceText = FString::Printf(TEXT("%.2f %s"), Micros / 1000000.0, *CurrencyCode);
+
+		Catalog.Add(ProductID, MoveTemp(Product));
+	}
+}
+
+float UPurchaseProxyInterfaceFake::RollLatency(const FFakeStoreLatency& Latency)
+{
+	return Random.FRandRange(Latency.MinSeconds, FMath::Max(Latency.MinSeconds, Latency.MaxSeconds));
+}
+
+bool UPurchaseProxyInterfaceFake::Roll(float Rate)
+{
+	return Rate > 0.f && Random.FRand() < Rate;
+}
+
+void UPurchaseProxyInterfaceFake::Schedule(float Delay, TFunction<void()>&& Callback)
+{
+	// Weak lambda, callbacks of destroyed proxy are skipped by ticker
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this,
+		[Callback = MoveTemp(Callback)](float)
+		{
+			Callback();
+			return false;
+		}), Delay);
+}
+
+void UPurchaseProxyInterfaceFake::ScheduleWithDuplicates(float Delay, const TFunction<void()>& Callback)
+{
+	Schedule(Delay, TFunction<void()>(Callback));
+
+	if(Roll(DuplicateCallbackRate))
+	{
+		Schedule(Delay + RollLatency(QueryLatency), TFunction<void()>(Callback));
+	}
+}
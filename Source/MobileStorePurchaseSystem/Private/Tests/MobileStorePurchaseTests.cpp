@@ -0,0 +1,329 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Benchmarks/MobileStorePurchaseBenchmark.h"
+#include "Containers/Ticker.h"
+#include "Data/ShopItemData.h"
+#include "HAL/FileManager.h"
+#include "Managers/ManagerMobileStorePurchase.h"
+#include "Module/BillingFlightRecorder.h"
+#include "Proxies/PurchaseProxyInterfaceFake.h"
+
+namespace MobileStorePurchaseTests
+{
+	constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+	// Fake store answers through core ticker, tests drive it directly instead of waiting for frames
+	static bool TickUntil(TFunctionRef<bool()> Condition, double TimeoutSeconds = 10.0)
+	{
+		const double EndTime = FPlatformTime::Seconds() + TimeoutSeconds;
+
+		while(!Condition())
+		{
+			if(FPlatformTime::Seconds() > EndTime) return false;
+
+			FTSTicker::GetCoreTicker().Tick(0.01f);
+		}
+
+		return true;
+	}
+
+	static void TickFrames(int32 Frames)
+	{
+		for(int32 i = 0; i < Frames; ++i)
+		{
+			FTSTicker::GetCoreTicker().Tick(0.01f);
+		}
+	}
+
+	// Manager without InitManager, so no journal, caches or platform interface of the running game are involved
+	static UManagerMobileStorePurchase* MakeManager(UPurchaseProxyInterfaceFake*& OutFakeStore, float DuplicateCallbackRate = 0.f)
+	{
+		UManagerMobileStorePurchase* Manager = NewObject<UManagerMobileStorePurchase>(GetTransientPackage());
+
+		UPurchaseProxyInterfaceFake* FakeStore = NewObject<UPurchaseProxyInterfaceFake>(Manager);
+		FakeStore->QueryLatency = FFakeStoreLatency(0.f, 0.f);
+		FakeStore->PurchaseLatency = FFakeStoreLatency(0.f, 0.f);
+		FakeStore->FinalizeLatency = FFakeStoreLatency(0.f, 0.f);
+		FakeStore->QueryErrorRate = 0.f;
+		FakeStore->PurchaseErrorRate = 0.f;
+		FakeStore->FinalizeErrorRate = 0.f;
+		FakeStore->PendingPurchaseRate = 0.f;
+		FakeStore->DuplicateCallbackRate = DuplicateCallbackRate;
+
+		Manager->SetPurchaseInterface(FakeStore);
+
+		OutFakeStore = FakeStore;
+		return Manager;
+	}
+
+	struct FPurchaseResult
+	{
+		int32 Calls = 0;
+		bool bSuccess = false;
+		FPurchaseReceiptInfo Receipt;
+	};
+
+	static void StartPurchase(UManagerMobileStorePurchase* Manager, const FString& ProductID, TSharedRef<FPurchaseResult> Result)
+	{
+		Manager->StartPurchase(ProductID, true, FPurchaseCompleteDelegate::CreateLambda([Result](bool bSuccess, FPurchaseReceiptInfo Receipt)
+		{
+			Result->Calls++;
+			Result->bSuccess = bSuccess;
+			Result->Receipt = Receipt;
+		}));
+	}
+
+	static int32 CountFlightEvents(EBillingFlightEvent Event, const FString& TransactionID)
+	{
+		const uint32 TransactionHandle = FBillingFlightRecorder::GetTransactionHandle(TransactionID);
+
+		int32 Count = 0;
+		for(const FBillingFlightRecord& Record : FBillingFlightRecorder::Get().Snapshot())
+		{
+			Count += Record.Event == Event && Record.TransactionHandle == TransactionHandle ? 1 : 0;
+		}
+
+		return Count;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchaseCompleteTest, "MobileStorePurchase.Purchase.Completes", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchaseCompleteTest::RunTest(const FString& Parameters)
+{
+	UPurchaseProxyInterfaceFake* FakeStore = nullptr;
+	UManagerMobileStorePurchase* Manager = MobileStorePurchaseTests::MakeManager(FakeStore);
+
+	const FString ProductID = FakeStore->GetGeneratedProductID(0);
+	const TSharedRef<MobileStorePurchaseTests::FPurchaseResult> Result = MakeShared<MobileStorePurchaseTests::FPurchaseResult>();
+
+	MobileStorePurchaseTests::StartPurchase(Manager, ProductID, Result);
+
+	TestTrue("Purchase answered", MobileStorePurchaseTests::TickUntil([Result]() { return Result->Calls > 0; }));
+	TestTrue("Purchase succeeded", Result->bSuccess);
+	TestEqual("Receipt product", Result->Receipt.ProductID, ProductID);
+	TestFalse("Receipt has transaction", Result->Receipt.TransactionID.IsEmpty());
+	TestEqual("Transaction state", Manager->GetTransactionState(Result->Receipt.TransactionID), EPurchaseTransactionState::Purchased);
+
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchaseDuplicateTest, "MobileStorePurchase.Purchase.DuplicateCallbackIgnored", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchaseDuplicateTest::RunTest(const FString& Parameters)
+{
+	// Every store callback is delivered twice
+	UPurchaseProxyInterfaceFake* FakeStore = nullptr;
+	UManagerMobileStorePurchase* Manager = MobileStorePurchaseTests::MakeManager(FakeStore, 1.f);
+
+	const TSharedRef<MobileStorePurchaseTests::FPurchaseResult> Result = MakeShared<MobileStorePurchaseTests::FPurchaseResult>();
+	MobileStorePurchaseTests::StartPurchase(Manager, FakeStore->GetGeneratedProductID(1), Result);
+
+	TestTrue("Purchase answered", MobileStorePurchaseTests::TickUntil([Result]() { return Result->Calls > 0; }));
+
+	// Let duplicate arrive
+	MobileStorePurchaseTests::TickFrames(10);
+
+	const FString& TransactionID = Result->Receipt.TransactionID;
+	TestEqual("Request completed once", Result->Calls, 1);
+	TestTrue("Purchase delivered twice", MobileStorePurchaseTests::CountFlightEvents(EBillingFlightEvent::PurchaseDelivered, TransactionID) >= 2);
+	TestEqual("Purchase accepted once", MobileStorePurchaseTests::CountFlightEvents(EBillingFlightEvent::PurchaseAccepted, TransactionID), 1);
+
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchaseFinalizeOnceTest, "MobileStorePurchase.Purchase.FinalizeOnce", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchaseFinalizeOnceTest::RunTest(const FString& Parameters)
+{
+	UPurchaseProxyInterfaceFake* FakeStore = nullptr;
+	UManagerMobileStorePurchase* Manager = MobileStorePurchaseTests::MakeManager(FakeStore);
+
+	const TSharedRef<MobileStorePurchaseTests::FPurchaseResult> Result = MakeShared<MobileStorePurchaseTests::FPurchaseResult>();
+	MobileStorePurchaseTests::StartPurchase(Manager, FakeStore->GetGeneratedProductID(2), Result);
+
+	if(!TestTrue("Purchase answered", MobileStorePurchaseTests::TickUntil([Result]() { return Result->Calls > 0 && Result->bSuccess; })))
+	{
+		Manager->MarkAsGarbage();
+		return false;
+	}
+
+	const FString TransactionID = Result->Receipt.TransactionID;
+
+	Manager->MarkPurchaseGranted(TransactionID);
+	Manager->FinalizePurchase(Result->Receipt);
+	Manager->FinalizePurchase(Result->Receipt);
+
+	TestTrue("Store finalized purchase", MobileStorePurchaseTests::TickUntil([FakeStore, TransactionID]() { return FakeStore->IsPurchaseFinalized(TransactionID); }));
+	MobileStorePurchaseTests::TickFrames(10);
+
+	TestEqual("Store finalize calls", FakeStore->FinalizedCount, 1);
+	TestEqual("Transaction state", Manager->GetTransactionState(TransactionID), EPurchaseTransactionState::Finalized);
+
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchasePendingTest, "MobileStorePurchase.Purchase.Pending", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchasePendingTest::RunTest(const FString& Parameters)
+{
+	UPurchaseProxyInterfaceFake* FakeStore = nullptr;
+	UManagerMobileStorePurchase* Manager = MobileStorePurchaseTests::MakeManager(FakeStore);
+
+	// Every purchase is paid 0.5 s after it was placed
+	FakeStore->PendingPurchaseRate = 1.f;
+	FakeStore->PendingPurchaseLatency = FFakeStoreLatency(0.5f, 0.5f);
+
+	const TSharedRef<MobileStorePurchaseTests::FPurchaseResult> Result = MakeShared<MobileStorePurchaseTests::FPurchaseResult>();
+	const TSharedRef<FPurchaseReceiptInfo> PendingReceipt = MakeShared<FPurchaseReceiptInfo>();
+
+	const int32 RequestID = Manager->StartPurchase(FakeStore->GetGeneratedProductID(4), true,
+		FPurchaseCompleteDelegate::CreateLambda([Result](bool bSuccess, FPurchaseReceiptInfo Receipt)
+		{
+			Result->Calls++;
+			Result->bSuccess = bSuccess;
+			Result->Receipt = Receipt;
+		}),
+		FPurchasePendingDelegate::CreateLambda([PendingReceipt](FPurchaseReceiptInfo Receipt)
+		{
+			*PendingReceipt = Receipt;
+		})
+	);
+
+	if(!TestTrue("Pending reported", MobileStorePurchaseTests::TickUntil([PendingReceipt]() { return !PendingReceipt->TransactionID.IsEmpty(); })))
+	{
+		Manager->MarkAsGarbage();
+		return false;
+	}
+
+	const FString TransactionID = PendingReceipt->TransactionID;
+	TestEqual("Request not completed while pending", Result->Calls, 0);
+	TestEqual("Request state", Manager->GetPurchaseRequestState(RequestID), EPurchaseTransactionState::Pending);
+
+	// Store restore reports the order as pending until it is paid
+	const TSharedRef<FString> RestoredState = MakeShared<FString>();
+	const FDelegateHandle RestoreHandle = FakeStore->OnPurchasesRestored.AddLambda([RestoredState, TransactionID](const TArray<FPurchaseInfoRaw>& Purchases)
+	{
+		for(const FPurchaseInfoRaw& PurchaseInfo : Purchases)
+		{
+			if(PurchaseInfo.TransactionID != TransactionID) continue;
+
+			const FString* PurchaseState = PurchaseInfo.CustomData.Find("PurchaseState");
+			*RestoredState = PurchaseState ? *PurchaseState : FString();
+		}
+	});
+	FakeStore->RestorePurchases();
+
+	TestTrue("Restored while pending", MobileStorePurchaseTests::TickUntil([RestoredState]() { return !RestoredState->IsEmpty(); }));
+	TestEqual("Restored purchase state", *RestoredState, FString("2"));
+	TestEqual("Request not completed by restore", Result->Calls, 0);
+
+	TestTrue("Purchase paid", MobileStorePurchaseTests::TickUntil([Result]() { return Result->Calls > 0; }));
+	TestTrue("Purchase succeeded", Result->bSuccess);
+	TestEqual("Same transaction", Result->Receipt.TransactionID, TransactionID);
+	TestEqual("Transaction state", Manager->GetTransactionState(TransactionID), EPurchaseTransactionState::Purchased);
+	TestEqual("Purchase accepted once", MobileStorePurchaseTests::CountFlightEvents(EBillingFlightEvent::PurchaseAccepted, TransactionID), 1);
+
+	FakeStore->OnPurchasesRestored.Remove(RestoreHandle);
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchasePendingNotGrantedTest, "MobileStorePurchase.Purchase.PendingNotGranted", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchasePendingNotGrantedTest::RunTest(const FString& Parameters)
+{
+	UPurchaseProxyInterfaceFake* FakeStore = nullptr;
+	UManagerMobileStorePurchase* Manager = MobileStorePurchaseTests::MakeManager(FakeStore);
+
+	// Store answers are sent by hand below
+	FakeStore->PurchaseLatency = FFakeStoreLatency(1000.f, 1000.f);
+
+	const FString ProductID = FakeStore->GetGeneratedProductID(3);
+	const TSharedRef<MobileStorePurchaseTests::FPurchaseResult> Result = MakeShared<MobileStorePurchaseTests::FPurchaseResult>();
+	const TSharedRef<int32> PendingCalls = MakeShared<int32>(0);
+
+	const int32 RequestID = Manager->StartPurchase(ProductID, true,
+		FPurchaseCompleteDelegate::CreateLambda([Result](bool bSuccess, FPurchaseReceiptInfo Receipt)
+		{
+			Result->Calls++;
+			Result->bSuccess = bSuccess;
+			Result->Receipt = Receipt;
+		}),
+		FPurchasePendingDelegate::CreateLambda([PendingCalls](FPurchaseReceiptInfo Receipt)
+		{
+			(*PendingCalls)++;
+		})
+	);
+
+	FPurchaseInfoRaw PurchaseInfo;
+	PurchaseInfo.ProductID = ProductID;
+	PurchaseInfo.TransactionID = "pending_transaction";
+	PurchaseInfo.CustomData.Add("PurchaseState", "2");
+
+	// Play repeats pending purchases
+	FakeStore->OnProductPurchased.Broadcast(PurchaseInfo);
+	FakeStore->OnProductPurchased.Broadcast(PurchaseInfo);
+	MobileStorePurchaseTests::TickFrames(10);
+
+	TestEqual("Pending reported once", *PendingCalls, 1);
+	TestEqual("Request not completed", Result->Calls, 0);
+	TestEqual("Request state", Manager->GetPurchaseRequestState(RequestID), EPurchaseTransactionState::Pending);
+	TestEqual("Pending not accepted", MobileStorePurchaseTests::CountFlightEvents(EBillingFlightEvent::PurchaseAccepted, PurchaseInfo.TransactionID), 0);
+	TestEqual("Pending not finalized", FakeStore->FinalizedCount, 0);
+
+	PurchaseInfo.CustomData.Add("PurchaseState", "1");
+	FakeStore->OnProductPurchased.Broadcast(PurchaseInfo);
+
+	TestEqual("Paid purchase completes request", Result->Calls, 1);
+	TestTrue("Paid purchase succeeded", Result->bSuccess);
+	TestEqual("Paid transaction", Result->Receipt.TransactionID, PurchaseInfo.TransactionID);
+	TestEqual("Transaction state", Manager->GetTransactionState(PurchaseInfo.TransactionID), EPurchaseTransactionState::Purchased);
+
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchaseFindShopItemTest, "MobileStorePurchase.Index.FindShopItemByProductId", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchaseFindShopItemTest::RunTest(const FString& Parameters)
+{
+	UManagerMobileStorePurchase* Manager = NewObject<UManagerMobileStorePurchase>(GetTransientPackage());
+	UShopItemData* ShopItemData = NewObject<UShopItemData>(Manager);
+
+	Manager->AddProductToIndex("test_product", ShopItemData, false);
+
+	TestTrue("Indexed product found", Manager->FindShopItemByProductId("test_product") == ShopItemData);
+	TestNull("Unknown product", Manager->FindShopItemByProductId("unknown_product"));
+	TestFalse("Consumable flag from index", Manager->IsProductConsumable("test_product"));
+	TestTrue("Unknown products are consumed", Manager->IsProductConsumable("unknown_product"));
+
+	// Remembered miss is dropped once product is indexed
+	Manager->AddProductToIndex("unknown_product", ShopItemData, false);
+	TestTrue("Product indexed after miss found", Manager->FindShopItemByProductId("unknown_product") == ShopItemData);
+	TestFalse("Consumable flag after miss", Manager->IsProductConsumable("unknown_product"));
+
+	Manager->MarkAsGarbage();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMobileStorePurchaseBenchmarkTest, "MobileStorePurchase.Benchmark", MobileStorePurchaseTests::TestFlags)
+
+bool FMobileStorePurchaseBenchmarkTest::RunTest(const FString& Parameters)
+{
+	UMobileStorePurchaseBenchmark* Benchmark = UMobileStorePurchaseBenchmark::Run(20);
+
+	TestTrue("Benchmark finished", MobileStorePurchaseTests::TickUntil([Benchmark]() { return !Benchmark->IsRunning(); }, 60.0));
+	TestTrue("Results written", IFileManager::Get().FileExists(*Benchmark->GetResultsPath()));
+
+	return true;
+}
+
+#endif
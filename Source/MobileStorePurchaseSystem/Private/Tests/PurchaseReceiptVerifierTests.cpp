@@ -0,0 +1,104 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "RSA.h"
+#include "Algo/Reverse.h"
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+#include "Verification/PurchaseReceiptVerifier.h"
+
+namespace PurchaseReceiptVerifierTests
+{
+	constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+	// 1024 bit pair generated with openssl genrsa, public part in Play Console format
+	static const TCHAR* PublicKeyBase64 = TEXT("MIGfMA0GCSqGSIb3DQEBAQUAA4GNADCBiQKBgQDPuSY3QZJgWQMtKXIql4FJXn5ng1n4d+Wbnhkp9NCfARgeElHP33ZXXxxRFUCN7SG0CiGiz6iLrcgZP5ucYxCAD1kB6VM8Q8gZ5ExetRoFdAp5q2L23KmHXC/Bu5geN6qQR+KwHcKlWXEywO1eF7NweI6TkI2v+VrnQyrnIHoQrQIDAQAB");
+	static const TCHAR* ModulusHex = TEXT("CFB9263741926059032D29722A9781495E7E678359F877E59B9E1929F4D09F01181E1251CFDF76575F1C5115408DED21B40A21A2CFA88BADC8193F9B9C6310800F5901E9533C43C819E44C5EB51A05740A79AB62F6DCA9875C2FC1BB981E37AA9047E2B01DC2A5597132C0ED5E17B370788E93908DAFF95AE7432AE7207A10AD");
+	static const TCHAR* PublicExponentHex = TEXT("010001");
+	static const TCHAR* PrivateExponentHex = TEXT("C1A34239BE599A913FC1C8E2114C3C8C4D971E1DB730456C783DD00D699754B22B6E54FB8901320B4EB151F0B2C5DB2950F124DBE622A35AF3AE7DBA2CF5B8394A8B1C2C2D3823EE2FBA3DC75E10E3E4504E4F62A59E31EC06B8C9D28E319E2136183A331058B1AE9A358D4DD5740DA1A568FD695B9E992A0FE757670946D20D");
+
+	static const TCHAR* PurchaseJson = TEXT("{\"orderId\":\"GPA.3301-4412-5523-66789\",\"packageName\":\"com.shenkns.test\",\"productId\":\"coins_100\",\"purchaseTime\":1700000000000,\"purchaseState\":0,\"purchaseToken\":\"test_token_1\",\"quantity\":1,\"acknowledged\":false}");
+
+	static TArray<uint8> HexToLittleEndian(const FString& Hex)
+	{
+		TArray<uint8> Bytes;
+		Bytes.SetNumZeroed((Hex.Len() + 1) / 2);
+		HexToBytes(Hex, Bytes.GetData());
+
+		// FRSA takes key numbers little endian
+		Algo::Reverse(Bytes);
+		return Bytes;
+	}
+
+	// Same as SHA1withRSA Google Play uses: PKCS#1 v1.5 padded DigestInfo, encrypted with private key
+	static FString Sign(const FString& SignedData)
+	{
+		const FRSAKeyHandle Key = FRSA::CreateKey(HexToLittleEndian(PublicExponentHex), HexToLittleEndian(PrivateExponentHex), HexToLittleEndian(ModulusHex));
+		if(!Key) return FString();
+
+		static const uint8 Sha1DigestInfoPrefix[] = { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+
+		TArray<uint8> DigestInfo(Sha1DigestInfoPrefix, UE_ARRAY_COUNT(Sha1DigestInfoPrefix));
+		DigestInfo.AddUninitialized(FSHA1::DigestSize);
+
+		const FTCHARToUTF8 Data(*SignedData);
+		FSHA1::HashBuffer(Data.Get(), Data.Length(), DigestInfo.GetData() + UE_ARRAY_COUNT(Sha1DigestInfoPrefix));
+
+		TArray<uint8> Signature;
+		const int32 SignatureSize = FRSA::EncryptPrivate(DigestInfo, Signature, Key);
+
+		FRSA::DestroyKey(Key);
+
+		if(SignatureSize <= 0) return FString();
+
+		Signature.SetNum(SignatureSize);
+		return FBase64::Encode(Signature);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPurchaseReceiptVerifierValidTest, "MobileStorePurchase.Verification.ValidSignature", PurchaseReceiptVerifierTests::TestFlags)
+
+bool FPurchaseReceiptVerifierValidTest::RunTest(const FString& Parameters)
+{
+	const FString Signature = PurchaseReceiptVerifierTests::Sign(PurchaseReceiptVerifierTests::PurchaseJson);
+	if(!TestFalse("Purchase signed", Signature.IsEmpty())) return false;
+
+	TestTrue("Signature valid", FPurchaseReceiptVerifier::VerifyGooglePlaySignature(PurchaseReceiptVerifierTests::PublicKeyBase64, PurchaseReceiptVerifierTests::PurchaseJson, Signature));
+	TestTrue("Purchase matches", FPurchaseReceiptVerifier::MatchesPurchase(PurchaseReceiptVerifierTests::PurchaseJson, "coins_100", "test_token_1"));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPurchaseReceiptVerifierTamperedTest, "MobileStorePurchase.Verification.TamperedData", PurchaseReceiptVerifierTests::TestFlags)
+
+bool FPurchaseReceiptVerifierTamperedTest::RunTest(const FString& Parameters)
+{
+	const FString Signature = PurchaseReceiptVerifierTests::Sign(PurchaseReceiptVerifierTests::PurchaseJson);
+	if(!TestFalse("Purchase signed", Signature.IsEmpty())) return false;
+
+	const FString TamperedJson = FString(PurchaseReceiptVerifierTests::PurchaseJson).Replace(TEXT("coins_100"), TEXT("coins_999"));
+
+	TestFalse("Tampered data rejected", FPurchaseReceiptVerifier::VerifyGooglePlaySignature(PurchaseReceiptVerifierTests::PublicKeyBase64, TamperedJson, Signature));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPurchaseReceiptVerifierWrongProductTest, "MobileStorePurchase.Verification.WrongProduct", PurchaseReceiptVerifierTests::TestFlags)
+
+bool FPurchaseReceiptVerifierWrongProductTest::RunTest(const FString& Parameters)
+{
+	const FString Signature = PurchaseReceiptVerifierTests::Sign(PurchaseReceiptVerifierTests::PurchaseJson);
+	if(!TestFalse("Purchase signed", Signature.IsEmpty())) return false;
+
+	// Genuine receipt replayed for other product
+	TestTrue("Signature valid", FPurchaseReceiptVerifier::VerifyGooglePlaySignature(PurchaseReceiptVerifierTests::PublicKeyBase64, PurchaseReceiptVerifierTests::PurchaseJson, Signature));
+	TestFalse("Other product rejected", FPurchaseReceiptVerifier::MatchesPurchase(PurchaseReceiptVerifierTests::PurchaseJson, "gems_500", "test_token_1"));
+	TestFalse("Other token rejected", FPurchaseReceiptVerifier::MatchesPurchase(PurchaseReceiptVerifierTests::PurchaseJson, "coins_100", "test_token_2"));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,250 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#include "Verification/PurchaseReceiptVerifier.h"
+
+#include "LogSystem.h"
+#include "RSA.h"
+#include "Algo/Reverse.h"
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "Misc/Base64.h"
+#include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
+#include "Module/MobileStorePurchaseSystemModule.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace ReceiptVerification
+{
+	// ASN.1 DigestInfo header of SHA1 hash inside PKCS#1 v1.5 signature
+	static const uint8 Sha1DigestInfoPrefix[] = { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 };
+
+	static bool ReadDerHeader(const TArray<uint8>& Der, int32& Offset, uint8 ExpectedTag, int32& OutLength)
+	{
+		if(Offset + 2 > Der.Num() || Der[Offset] != ExpectedTag) return false;
+		Offset++;
+
+		int32 Length = Der[Offset++];
+		if(Length & 0x80)
+		{
+			const int32 LengthBytes = Length & 0x7F;
+			if(LengthBytes < 1 || LengthBytes > 3 || Offset + LengthBytes > Der.Num()) return false;
+
+			Length = 0;
+			for(int32 i = 0; i < LengthBytes; ++i)
+			{
+				Length = (Length << 8) | Der[Offset++];
+			}
+		}
+
+		if(Offset + Length > Der.Num()) return false;
+
+		OutLength = Length;
+		return true;
+	}
+
+	static bool ReadDerInteger(const TArray<uint8>& Der, int32& Offset, TArray<uint8>& OutValue)
+	{
+		int32 Length = 0;
+		if(!ReadDerHeader(Der, Offset, 0x02, Length)) return false;
+
+		// Leading zero only keeps number positive
+		int32 Start = Offset;
+		while(Start < Offset + Length - 1 && Der[Start] == 0)
+		{
+			Start++;
+		}
+
+		OutValue = TArray<uint8>(Der.GetData() + Start, Offset + Length - Start);
+		Offset += Length;
+
+		return OutValue.Num() > 0;
+	}
+
+	// SubjectPublicKeyInfo { AlgorithmIdentifier, BIT STRING { RSAPublicKey { Modulus, Exponent } } }
+	static bool ParsePublicKey(const TArray<uint8>& Der, TArray<uint8>& OutModulus, TArray<uint8>& OutExponent)
+	{
+		int32 Offset = 0;
+		int32 Length = 0;
+
+		if(!ReadDerHeader(Der, Offset, 0x30, Length)) return false;
+
+		if(!ReadDerHeader(Der, Offset, 0x30, Length)) return false;
+		Offset += Length;
+
+		if(!ReadDerHeader(Der, Offset, 0x03, Length) || Length < 1 || Der[Offset] != 0) return false;
+		Offset++;
+
+		if(!ReadDerHeader(Der, Offset, 0x30, Length)) return false;
+
+		return ReadDerInteger(Der, Offset, OutModulus) && ReadDerInteger(Der, Offset, OutExponent);
+	}
+
+	static FRSAKeyHandle CreateKey(const FString& PublicKeyBase64)
+	{
+		FString Base64 = PublicKeyBase64;
+		Base64.ReplaceInline(TEXT("\n"), TEXT(""));
+		Base64.ReplaceInline(TEXT("\r"), TEXT(""));
+		Base64.ReplaceInline(TEXT(" "), TEXT(""));
+
+		TArray<uint8> Der;
+		if(Base64.IsEmpty() || !FBase64::Decode(Base64, Der)) return nullptr;
+
+		TArray<uint8> Modulus;
+		TArray<uint8> Exponent;
+		if(!ParsePublicKey(Der, Modulus, Exponent)) return nullptr;
+
+		// DER numbers are big endian, FRSA takes little endian
+		Algo::Reverse(Modulus);
+		Algo::Reverse(Exponent);
+
+		return FRSA::CreateKey(Exponent, TArray<uint8>(), Modulus);
+	}
+
+	static bool VerifySignature(FRSAKeyHandle Key, const FString& SignedData, const FString& SignatureBase64)
+	{
+		TArray<uint8> Signature;
+		if(!Key || !FBase64::Decode(SignatureBase64, Signature) || Signature.Num() * 8 != FRSA::GetKeySizeInBits(Key)) return false;
+
+		TArray<uint8> DigestInfo;
+		const int32 DigestInfoSize = FRSA::DecryptPublic(Signature, DigestInfo, Key);
+		if(DigestInfoSize != sizeof(Sha1DigestInfoPrefix) + FSHA1::DigestSize || DigestInfo.Num() < DigestInfoSize) return false;
+
+		if(FMemory::Memcmp(DigestInfo.GetData(), Sha1DigestInfoPrefix, sizeof(Sha1DigestInfoPrefix)) != 0) return false;
+
+		// Google signs original UTF-8 purchase JSON
+		const FTCHARToUTF8 Data(*SignedData);
+
+		uint8 Hash[FSHA1::DigestSize];
+		FSHA1::HashBuffer(Data.Get(), Data.Length(), Hash);
+
+		return FMemory::Memcmp(DigestInfo.GetData() + sizeof(Sha1DigestInfoPrefix), Hash, FSHA1::DigestSize) == 0;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand MobileStorePurchaseVerifySignatureCommand(
+	TEXT("MobileStorePurchase.VerifySignature"),
+	TEXT("Checks Google Play signature with local files. Arguments: public key base64 file, signed data file, signature base64 file"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FString PublicKey, SignedData, Signature;
+		if(Args.Num() < 3
+			|| !FFileHelper::LoadFileToString(PublicKey, *Args[0])
+			|| !FFileHelper::LoadFileToString(SignedData, *Args[1])
+			|| !FFileHelper::LoadFileToString(Signature, *Args[2]))
+		{
+			LOG_STATIC(LogMobileStorePurchaseSystem, "VerifySignature: can't read files")
+			return;
+		}
+
+		const bool bValid = FPurchaseReceiptVerifier::VerifyGooglePlaySignature(PublicKey, SignedData, Signature.TrimStartAndEnd());
+
+		LOG_STATIC(LogMobileStorePurchaseSystem, "VerifySignature: %s", bValid ? TEXT("valid") : TEXT("invalid"))
+	})
+);
+#endif
+
+struct FPurchaseReceiptVerifier::FState
+{
+	FRSAKeyHandle Key = nullptr;
+
+	// Game thread only. Transaction and product, so verified token can't be reused for other product
+	TSet<FString> VerifiedPurchases;
+
+	~FState()
+	{
+		if(Key)
+		{
+			FRSA::DestroyKey(Key);
+		}
+	}
+
+	static FString GetPurchaseKey(const FString& TransactionID, const FString& ProductID)
+	{
+		return TransactionID + TEXT("|") + ProductID;
+	}
+};
+
+FPurchaseReceiptVerifier::FPurchaseReceiptVerifier(const FString& GooglePlayPublicKey) : State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+	State->Key = ReceiptVerification::CreateKey(GooglePlayPublicKey);
+
+	if(!State->Key)
+	{
+		LOG_STATIC(LogMobileStorePurchaseSystem, "Google Play public key is missing or invalid, signed purchases will be rejected")
+	}
+}
+
+bool FPurchaseReceiptVerifier::IsKeyValid() const
+{
+	return State->Key != nullptr;
+}
+
+bool FPurchaseReceiptVerifier::NeedsVerification(const FPurchaseInfoRaw& PurchaseInfo)
+{
+	return PurchaseInfo.CustomData.Contains("OriginalJson");
+}
+
+bool FPurchaseReceiptVerifier::IsVerified(const FPurchaseInfoRaw& PurchaseInfo) const
+{
+	return State->VerifiedPurchases.Contains(FState::GetPurchaseKey(PurchaseInfo.TransactionID, PurchaseInfo.ProductID));
+}
+
+void FPurchaseReceiptVerifier::Verify(const FPurchaseInfoRaw& PurchaseInfo, FPurchaseVerifyDelegate OnComplete)
+{
+	FString PurchaseKey = FState::GetPurchaseKey(PurchaseInfo.TransactionID, PurchaseInfo.ProductID);
+
+	if(State->VerifiedPurchases.Contains(PurchaseKey))
+	{
+		OnComplete.ExecuteIfBound(true, FString());
+		return;
+	}
+
+	const FString* SignedData = PurchaseInfo.CustomData.Find("OriginalJson");
+	const FString* Signature = PurchaseInfo.CustomData.Find("Signature");
+
+	if(!State->Key || !SignedData || !Signature || Signature->IsEmpty())
+	{
+		OnComplete.ExecuteIfBound(false, State->Key ? "Purchase is not signed" : "No Google Play public key");
+		return;
+	}
+
+	Async(EAsyncExecution::ThreadPool, [State = State, PurchaseKey = MoveTemp(PurchaseKey), SignedData = *SignedData, Signature = *Signature,
+		ProductID = PurchaseInfo.ProductID, TransactionID = PurchaseInfo.TransactionID, OnComplete = MoveTemp(OnComplete)]() mutable
+	{
+		const bool bValid = ReceiptVerification::VerifySignature(State->Key, SignedData, Signature)
+			&& MatchesPurchase(SignedData, ProductID, TransactionID);
+
+		FMobileStorePurchaseSystemModule::Get().GetBillingEventQueue().Enqueue(EBillingEventPriority::Purchase, [State = MoveTemp(State), PurchaseKey = MoveTemp(PurchaseKey), bValid, OnComplete = MoveTemp(OnComplete)]()
+		{
+			if(bValid)
+			{
+				State->VerifiedPurchases.Add(PurchaseKey);
+			}
+
+			OnComplete.ExecuteIfBound(bValid, bValid ? FString() : FString("Invalid purchase signature"));
+		});
+	});
+}
+
+bool FPurchaseReceiptVerifier::VerifyGooglePlaySignature(const FString& PublicKeyBase64, const FString& SignedData, const FString& SignatureBase64)
+{
+	const FRSAKeyHandle Key = ReceiptVerification::CreateKey(PublicKeyBase64);
+	if(!Key) return false;
+
+	const bool bValid = ReceiptVerification::VerifySignature(Key, SignedData, SignatureBase64);
+
+	FRSA::DestroyKey(Key);
+
+	return bValid;
+}
+
+bool FPurchaseReceiptVerifier::MatchesPurchase(const FString& SignedData, const FString& ProductID, const FString& TransactionID)
+{
+	TSharedPtr<FJsonObject> PurchaseJson;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(SignedData);
+	if(!FJsonSerializer::Deserialize(Reader, PurchaseJson) || !PurchaseJson.IsValid()) return false;
+
+	return PurchaseJson->GetStringField("productId") == ProductID && PurchaseJson->GetStringField("purchaseToken") == TransactionID;
+}
@@ -0,0 +1,69 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "UObject/Object.h"
+
+#include "Managers/ManagerMobileStorePurchase.h"
+
+#include "MobileStorePurchaseBenchmark.generated.h"
+
+class FJsonObject;
+class UPurchaseProxyInterfaceFake;
+class UShopItemMobileStorePurchase;
+
+// Measures purchase pipeline hot paths against fake store and writes results as JSON to Saved/Benchmarks.
+// Run with "MobileStorePurchase.Benchmark [PurchaseIterations]" console command
+UCLASS()
+class MOBILESTOREPURCHASESYSTEM_API UMobileStorePurchaseBenchmark : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	static UMobileStorePurchaseBenchmark* Run(int32 PurchaseIterations = 100);
+
+	bool IsRunning() const { return bRunning; }
+
+	FString GetResultsPath() const { return ResultsPath; }
+
+private:
+
+	UPROPERTY()
+	UManagerMobileStorePurchase* PurchaseManager;
+
+	UPROPERTY()
+	UPurchaseProxyInterfaceFake* FakeStore;
+
+	UPROPERTY()
+	UShopItemMobileStorePurchase* ShopItem;
+
+	TSharedPtr<FJsonObject> Results;
+	FString ResultsPath;
+	bool bRunning = false;
+
+	int32 PurchaseIterations = 0;
+	int32 PurchasesLeft = 0;
+	double PurchaseStartTime = 0.0;
+
+	// Buy to FinishPurchase of shop item, what player waits for
+	TArray<double> PurchaseTimes;
+
+	// StartPurchase to completion on manager alone, without widget and shop item overhead
+	TArray<double> ManagerPurchaseTimes;
+
+	void Start(int32 InPurchaseIterations);
+	void Finish();
+
+	void RunCatalogIngest(int32 ProductsNum);
+	void RunLookups(int32 ProductsNum);
+
+	void StartNextManagerPurchase();
+	void OnManagerPurchaseComplete(bool Success, FPurchaseReceiptInfo Receipt);
+
+	void StartShopItemPurchases();
+	void StartNextShopItemPurchase();
+	void OnShopItemPurchaseFinished(bool Success);
+
+	static TArray<FStoreProduct> MakeProducts(int32 ProductsNum);
+};
@@ -0,0 +1,71 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Interfaces/OnlineStoreInterfaceV2.h"
+
+// Plain product description as stores deliver it, prices are in micros of currency unit
+struct MOBILESTOREPURCHASESYSTEM_API FStoreProduct
+{
+	FString ProductID;
+	FString Title;
+	FString Description;
+	FString PriceText;
+	FString CurrencyCode;
+	int64 MicrosPrice = 0;
+
+	static FStoreProduct FromOffer(const FOnlineStoreOffer& Offer);
+};
+
+// Store products kept as dense arrays indexed by product handle. FText and FOnlineStoreOffer are built
+// only for products somebody asks for, so big catalogs cost a few strings and numbers per product
+class MOBILESTOREPURCHASESYSTEM_API FStoreCatalog
+{
+public:
+
+	// Handles stay valid until Reset, products are never removed one by one
+	int32 Add(const FStoreProduct& Product, bool bFresh);
+
+	int32 FindHandle(const FString& ProductID) const;
+	bool IsValidHandle(int32 Handle) const { return MicrosPrices.IsValidIndex(Handle); }
+
+	bool Contains(const FString& ProductID) const { return FindHandle(ProductID) != INDEX_NONE; }
+	bool IsFresh(const FString& ProductID) const;
+
+	int32 Num() const { return MicrosPrices.Num(); }
+
+	void Reserve(int32 Number);
+	void Reset();
+
+	const FString& GetProductID(int32 Handle) const;
+	int64 GetMicrosPrice(int32 Handle) const { return MicrosPrices[Handle]; }
+	const FString& GetCurrencyCode(int32 Handle) const { return Currencies[CurrencyIndices[Handle]]; }
+	bool IsFresh(int32 Handle) const { return FreshFlags[Handle]; }
+
+	FStoreProduct GetProduct(int32 Handle) const;
+
+	// Offer view with FText built on first request, cached until product is replaced
+	TSharedPtr<FOnlineStoreOffer> GetOffer(int32 Handle) const;
+
+	// Heap memory of the catalog, including cached offer views
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	// Set is never removed from, so element ids are dense and double as handles
+	TSet<FString> ProductIDs;
+
+	TArray<FString> Titles;
+	TArray<FString> Descriptions;
+	TArray<FString> PriceTexts;
+	TArray<int64> MicrosPrices;
+	TArray<uint16> CurrencyIndices;
+	TBitArray<> FreshFlags;
+
+	// Interned, catalogs rarely have more than a couple of currencies
+	TArray<FString> Currencies;
+
+	mutable TMap<int32, TSharedPtr<FOnlineStoreOffer>> OfferViews;
+
+	uint16 InternCurrency(const FString& CurrencyCode);
+};
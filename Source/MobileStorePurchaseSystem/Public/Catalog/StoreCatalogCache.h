@@ -0,0 +1,27 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Catalog/StoreCatalog.h"
+
+// Versioned binary file with last received store offers, used to show prices before store answers
+class MOBILESTOREPURCHASESYSTEM_API FStoreCatalogCache
+{
+public:
+
+	// Cache is stored per platform and culture, prices are not valid across storefronts
+	static FString GetCatalogKey();
+
+	static FString GetCachePath(const FString& CatalogKey);
+
+	// Returns false if file is missing, corrupted, has other version or key, or is older than TimeToLive
+	static bool Load(const FString& CatalogKey, FTimespan TimeToLive, TArray<FStoreProduct>& OutProducts);
+
+	// Serializes catalog on calling thread and writes file on a worker thread
+	static void Save(const FString& CatalogKey, const FStoreCatalog& Catalog);
+
+private:
+
+	static constexpr uint32 FileMagic = 0x4D535043;
+	static constexpr uint32 FileVersion = 2;
+};
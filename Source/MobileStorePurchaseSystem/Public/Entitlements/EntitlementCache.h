@@ -0,0 +1,42 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Owned non-consumable products, kept on disk so ownership is known without store round trip
+class MOBILESTOREPURCHASESYSTEM_API FEntitlementCache
+{
+public:
+
+	static FString GetCachePath();
+
+	// Missing or corrupted file leaves cache empty and stale
+	void Load();
+
+	// Serializes on calling thread and writes file on a worker thread
+	void Save() const;
+
+	bool IsOwned(const FString& ProductID) const { return OwnedProducts.Contains(ProductID); }
+
+	// Returns true if cache changed and should be saved
+	bool Grant(const FString& ProductID, const FString& TransactionID);
+
+	// Replaces owned products with full store answer, so refunded products are dropped. Returns true if anything changed
+	bool Reconcile(const TMap<FString, FString>& StoreOwnedProducts);
+
+	bool IsStale(FTimespan ReconcileInterval) const;
+
+	FDateTime GetLastReconcileTime() const { return FDateTime(LastReconcileTime); }
+
+	// ProductID -> TransactionID
+	const TMap<FString, FString>& GetOwnedProducts() const { return OwnedProducts; }
+
+private:
+
+	TMap<FString, FString> OwnedProducts;
+	int64 LastReconcileTime = 0;
+
+	static constexpr uint32 FileMagic = 0x4D535045;
+	static constexpr uint32 FileVersion = 1;
+};
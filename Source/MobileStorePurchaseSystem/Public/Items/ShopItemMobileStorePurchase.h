@@ -4,6 +4,7 @@
 
 #include "Items/ShopItem.h"
 
+#include "Containers/Ticker.h"
 #include "Interfaces/OnlineStoreInterfaceV2.h"
 #include "Interfaces/OnlinePurchaseInterface.h"
 #include "Managers/ManagerMobileStorePurchase.h"
@@ -11,6 +12,9 @@
 #include "ShopItemMobileStorePurchase.generated.h"
 
 class UPurchaseWidget;
+class UShopItemData;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FStorePurchaseFinishedEvent, bool);
 
 UCLASS()
 class MOBILESTOREPURCHASESYSTEM_API UShopItemMobileStorePurchase : public UShopItem
@@ -19,6 +23,7 @@ class MOBILESTOREPURCHASESYSTEM_API UShopItemMobileStorePurchase : public UShopI
 	
 protected:
 
+	// Shared widget owned by purchase manager, set while this item shows it
 	UPROPERTY(BlueprintReadOnly, Category = "Shop|MobileStorePurchase")
 	UPurchaseWidget* PurchaseWidget;
 
@@ -26,15 +31,44 @@ protected:
 
 	bool bStoreInfoRecieved;
 
+	// Store info came from store in this session, not from catalog cache
+	bool bStoreInfoFresh;
+
+	// Order placed, waiting for payment. Purchase completes when store delivers it as paid
+	bool bPurchasePending = false;
+
 	FPurchaseReceipt PurchaseReceipt;
 
 	UPROPERTY()
 	FTimerHandle FinalizeTimer;
+
+	FDelegateHandle ProductSubscriptionHandle;
+
+	// Kept for teardown, when manager and product id getters may not be safe to call. Manager is set once item is registered
+	TWeakObjectPtr<UManagerMobileStorePurchase> SubscribedManager;
+	FString SubscribedProductID;
+
+	// Store flow starts on next tick after purchase widget is shown
+	FTSTicker::FDelegateHandle PurchaseStartHandle;
+	FTSTicker::FDelegateHandle PurchaseWidgetCloseHandle;
+
+	double BuyStartTime = 0.0;
+	double PurchaseWidgetOpenTime = 0.0;
 	
+public:
+
+	// Native listeners outside of shop, like benchmark, learn here when store purchase of this item ended
+	FStorePurchaseFinishedEvent OnStorePurchaseFinished;
+
 public:
 
 	virtual void Init_Implementation() override;
 
+	// For items created outside of shop manager, like benchmark ones
+	void InitStandalone(UShopItemData* Data, UManagerMobileStorePurchase* Manager);
+
+	virtual void BeginDestroy() override;
+
 	virtual bool Buy_Implementation() override;
 
 	virtual void Finish_Implementation() override;
@@ -55,18 +89,35 @@ public:
 	UFUNCTION(BlueprintPure, Category="Shop|MobileStorePurchase")
 	bool IsStoreInfoReady() const;
 
+	UFUNCTION(BlueprintPure, Category="Shop|MobileStorePurchase")
+	bool IsStoreInfoFresh() const { return bStoreInfoFresh; }
+
+	UFUNCTION(BlueprintPure, Category="Shop|MobileStorePurchase")
+	bool IsPurchasePending() const { return bPurchasePending; }
+
 	UFUNCTION(BlueprintPure, Category = "Shop|MobileStorePurchase")
 	UManagerMobileStorePurchase* GetMobileStorePurchaseManager() const;
 
 	UFUNCTION(BlueprintPure, BlueprintNativeEvent, Category="Shop|MobileStorePurchase")
 	FString GetProductID() const;
 
+	// Purchase of this product that arrived without request, like one replayed from journal after restart
+	void GrantRecoveredPurchase(const FPurchaseReceiptInfo& Reciept);
+
 protected:
 
 	UFUNCTION()
 	void ProcessPurchaseComplete(bool Success, FPurchaseReceiptInfo Reciept);
 
+	void ProcessPurchasePending(FPurchaseReceiptInfo Reciept);
+
+	void InitWithManager(UManagerMobileStorePurchase* Manager);
+
+	void FinishStorePurchase(bool Success);
+
 	void CheckProduct();
+
+	void OnProductUpdated(const FString& ProductID);
 	
 private:
 
@@ -75,4 +126,5 @@ private:
 
 	void OpenPurchaseWidget();
 	void ClosePurchaseWidget();
+	void ReleasePurchaseWidget();
 };
@@ -0,0 +1,70 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Proxies/PurchaseProxyInterface.h"
+
+class IFileHandle;
+
+enum class EPurchaseJournalRecord : uint8
+{
+	// Store delivered purchase, content not granted yet
+	Recorded,
+	// Content granted, store not finalized yet
+	Granted,
+	Finalized
+};
+
+struct FPurchaseJournalEntry
+{
+	FPurchaseInfoRaw PurchaseInfo;
+	EPurchaseJournalRecord State = EPurchaseJournalRecord::Recorded;
+};
+
+// Append only file of purchase records, every record is flushed before call returns.
+// Purchase goes record -> grant -> finalize, unfinished ones are found on next start
+class MOBILESTOREPURCHASESYSTEM_API FPurchaseJournal
+{
+public:
+
+	explicit FPurchaseJournal(const FString& InPath);
+	~FPurchaseJournal();
+
+	static FString GetJournalPath();
+
+	// Reads all records, torn or corrupted tail left by crash is dropped. Returns false if file has other format
+	bool Load();
+
+	// Rewrites file with unfinished entries only
+	void Compact();
+
+	// Recording same transaction again does nothing
+	bool Record(const FPurchaseInfoRaw& PurchaseInfo);
+	bool MarkGranted(const FString& TransactionID);
+	bool MarkFinalized(const FString& TransactionID);
+
+	const FPurchaseJournalEntry* Find(const FString& TransactionID) const { return Entries.Find(TransactionID); }
+
+	// Unfinished entries only
+	const TMap<FString, FPurchaseJournalEntry>& GetEntries() const { return Entries; }
+
+private:
+
+	bool OpenForAppend();
+	bool Append(EPurchaseJournalRecord Type, const FPurchaseInfoRaw& PurchaseInfo);
+
+	static void WriteRecord(FArchive& Ar, EPurchaseJournalRecord Type, const FPurchaseInfoRaw& PurchaseInfo);
+	static void WriteHeader(FArchive& Ar);
+
+	FString Path;
+	TUniquePtr<IFileHandle> FileHandle;
+
+	TMap<FString, FPurchaseJournalEntry> Entries;
+	int32 RecordsNum = 0;
+
+	static constexpr uint32 FileMagic = 0x4D53504A;
+	static constexpr uint32 FileVersion = 1;
+
+	// Finalized records kept in file before it is rewritten
+	static constexpr int32 CompactThreshold = 64;
+};
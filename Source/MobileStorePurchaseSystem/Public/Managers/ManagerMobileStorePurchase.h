@@ -5,15 +5,23 @@
 #include "Managers/Manager.h"
 
 #include "OnlineSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Blueprint/UserWidgetPool.h"
 #include "PlatformTypePurchases/PlatformTypePurchase.h"
 #include "Interfaces/OnlineStoreInterfaceV2.h"
+#include "Catalog/StoreCatalog.h"
+#include "Entitlements/EntitlementCache.h"
+#include "Journal/PurchaseJournal.h"
 #include "Proxies/PurchaseProxyInterface.h"
+#include "Verification/PurchaseReceiptVerifier.h"
 
 #include "ManagerMobileStorePurchase.generated.h"
 
 class UShopItemData;
+class UShopItemMobileStorePurchase;
 class UManagerMobileStorePurchase;
 class UPurchaseProxyInterface;
+class UPurchaseWidget;
 
 USTRUCT(BlueprintType)
 struct MOBILESTOREPURCHASESYSTEM_API FPurchaseReceiptInfo
@@ -21,7 +29,7 @@ struct MOBILESTOREPURCHASESYSTEM_API FPurchaseReceiptInfo
 	GENERATED_BODY()
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shop|MobileStorePurchase")
-	UShopItemData* ShopItemData;
+	UShopItemData* ShopItemData = nullptr;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shop|MobileStorePurchase")
 	FString ProductID;
@@ -33,9 +41,82 @@ struct MOBILESTOREPURCHASESYSTEM_API FPurchaseReceiptInfo
 	TMap<FString, FString> CustomData;
 };
 
+UENUM(BlueprintType)
+enum class EPurchaseTransactionState : uint8
+{
+	None,
+	// StartPurchase called, store flow not launched yet
+	Requested,
+	// Store purchase UI is shown, waiting for store answer
+	FlowLaunched,
+	// Order is placed, but not paid yet, like Play cash payments. Nothing is granted until store delivers it as purchased
+	Pending,
+	// Store reported successful payment, content is not granted yet
+	Purchased,
+	Granted,
+	Finalized,
+	Failed
+};
+
+// Cached lookup entry for shop item data owning a store ProductID
+struct FStoreProductIndexEntry
+{
+	TWeakObjectPtr<UShopItemData> ShopItemData;
+	bool bIsConsumable = false;
+};
+
+UENUM(BlueprintType)
+enum class EProductRequestPriority : uint8
+{
+	// Shown or about to be shown, sent with next batch
+	Visible,
+	// Sent only while no other product request is in flight
+	Prefetch
+};
+
+// Group of product ids sent to the store in a single request
+struct FProductRequestBatch
+{
+	int32 BatchID = 0;
+	TArray<FString> ProductIDs;
+	double StartTime = 0.0;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FPurchaseEvent, bool, Success, FPurchaseReceiptInfo, Reciept);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FPurchaseRestoreCompleteEvent, bool, Success, int32, RestoredNum);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FEntitlementsChangedEvent);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FBillingConnectionEvent, EBillingConnectionState, State);
 
 DECLARE_MULTICAST_DELEGATE(FShopProductReceiveEvent);
+DECLARE_MULTICAST_DELEGATE_OneParam(FShopProductsBatchReceiveEvent, const TArray<FString>& ProductIDs);
+DECLARE_DELEGATE_OneParam(FShopProductUpdateDelegate, const FString& ProductID);
+
+struct FProductSubscription
+{
+	FDelegateHandle Handle;
+	FShopProductUpdateDelegate Delegate;
+};
+
+// Completion of a single purchase request, called only for the request that started it
+DECLARE_DELEGATE_TwoParams(FPurchaseCompleteDelegate, bool, FPurchaseReceiptInfo);
+
+// Store took order but payment is pending, OnComplete follows once it is paid
+DECLARE_DELEGATE_OneParam(FPurchasePendingDelegate, FPurchaseReceiptInfo);
+
+struct FPurchaseTransaction
+{
+	int32 RequestID = 0;
+	FString ProductID;
+
+	// Assigned by store when purchase is delivered
+	FString TransactionID;
+	
+	EPurchaseTransactionState State = EPurchaseTransactionState::None;
+	double StartTime = 0.0;
+	
+	FPurchaseCompleteDelegate OnComplete;
+	FPurchasePendingDelegate OnPending;
+};
 
 UCLASS()
 class MOBILESTOREPURCHASESYSTEM_API UManagerMobileStorePurchase : public UManager
@@ -46,14 +127,39 @@ public:
 
 	friend IPlatformTypePurchase;
 
+	// Only for purchases that are new or changed since they were last seen
 	UPROPERTY(BlueprintAssignable, Category = "Shop")
 	FPurchaseEvent OnPurchaseRestore;
 
+	UPROPERTY(BlueprintAssignable, Category = "Shop")
+	FPurchaseRestoreCompleteEvent OnPurchaseRestoreComplete;
+
+	UPROPERTY(BlueprintAssignable, Category = "Shop")
+	FEntitlementsChangedEvent OnEntitlementsChanged;
+
+	// Store calls made while not connected wait in platform queue, no need to hold them back
+	UPROPERTY(BlueprintAssignable, Category = "Shop")
+	FBillingConnectionEvent OnBillingConnectionStateChanged;
+
 	UPROPERTY(BlueprintAssignable, Category = "Shop")
 	FPurchaseEvent OnPurchaseComplete;
 
+	// Purchase waits for payment, nothing to grant yet. Same purchase comes through OnPurchaseComplete when it is paid
+	UPROPERTY(BlueprintAssignable, Category = "Shop")
+	FPurchaseEvent OnPurchasePending;
+
 	FShopProductReceiveEvent OnProductsReceived;
 
+	// Fired once per store answer with ids of added or updated products
+	FShopProductsBatchReceiveEvent OnProductsBatchReceived;
+
+	// Store results of finalize batches
+	FPurchasesFinalizeEvent OnPurchasesFinalized;
+
+	// Delegate is called only when this ProductID is added or updated. Bind with weak delegates, dead ones are removed
+	FDelegateHandle SubscribeToProduct(const FString& ProductId, FShopProductUpdateDelegate Delegate);
+	void UnsubscribeFromProduct(const FString& ProductId, FDelegateHandle Handle);
+
 	UPROPERTY()
 	UPurchaseProxyInterface* PurchaseInterface;
 
@@ -63,8 +169,97 @@ protected:
 	TUniquePtr<IPlatformTypePurchase> PlatformImpl = nullptr;
 
 	TArray<FString> PendingProductIdRequests;
+
+	// Used by platform implementation, proxy requests are tracked in ProductRequestBatches
 	TArray<FString> ProductIdRequestsInProgress;
-	TMap<FString, TSharedPtr<FOnlineStoreOffer>> StoreProducts;
+
+	// Pending and in progress ids, for dedupe
+	TSet<FString> ScheduledProductIds;
+	TArray<FProductRequestBatch> ProductRequestBatches;
+	int32 LastProductRequestBatchID = 0;
+	FTSTicker::FDelegateHandle ProductRequestFlushHandle;
+
+	// Low priority ids in request order. Ids promoted to visible stay in queue and are skipped when popped
+	TArray<FString> PrefetchProductIds;
+	TSet<FString> PrefetchProductIdSet;
+	int32 PrefetchQueueHead = 0;
+	FTSTicker::FDelegateHandle ProductPrefetchHandle;
+
+	// Products received from store in this session are fresh, others are loaded from catalog cache
+	FStoreCatalog StoreCatalog;
+	bool bCatalogCacheDirty = false;
+
+	TMap<FString, TArray<FProductSubscription, TInlineAllocator<1>>> ProductSubscriptions;
+
+	// Open purchases by request id, removed when finalized or failed
+	TMap<int32, FPurchaseTransaction> PurchaseTransactions;
+	TMap<FString, int32> PurchaseRequestIDs;
+	int32 LastPurchaseRequestID = 0;
+
+	// Store redelivers purchases until they are finalized, ignore repeated ones
+	TSet<FString> FinalizedTransactionIDs;
+
+	// Granted purchases until store confirms finalize, redelivery of these is only finalized again. Kept without journal too
+	TMap<FString, FPurchaseReceiptInfo> GrantedTransactions;
+
+	// Pending transaction -> request waiting for its payment
+	TMap<FString, int32> PendingPurchaseRequestIDs;
+
+	// Live shop items by product id, they grant purchases that arrive without open request
+	TMap<FString, TWeakObjectPtr<UShopItemMobileStorePurchase>> ShopItemsByProduct;
+
+	// Purchases without open request and without shop item for their product yet, by product id
+	TMap<FString, TArray<FPurchaseReceiptInfo>> UnclaimedPurchases;
+
+	TUniquePtr<FPurchaseJournal> PurchaseJournal;
+
+	// Set when signature check is on, purchases wait in VerifyingTransactionIDs until it answers
+	TUniquePtr<FPurchaseReceiptVerifier> PurchaseVerifier;
+	TSet<FString> VerifyingTransactionIDs;
+
+	// Restored owned transaction -> purchase state it was last reported with
+	TMap<FString, FString> KnownRestoreStates;
+	bool bRestoreInProgress = false;
+	int32 RestoredPurchasesNum = 0;
+
+	TUniquePtr<FEntitlementCache> EntitlementCache;
+
+	// Verified non-consumables reported by restore in progress, ProductID -> TransactionID
+	TMap<FString, FString> RestoreOwnedProducts;
+
+	// Restored non-consumables still being verified, TransactionID -> ProductID. Reconcile waits for them
+	TMap<FString, FString> RestoreVerifyingProducts;
+	bool bRestoreReconcilePending = false;
+
+	// Finalize calls made within one frame are sent to store as one batch
+	TArray<FPurchaseInfoRaw> PendingFinalizePurchases;
+	FTSTicker::FDelegateHandle FinalizeFlushHandle;
+
+	// Purchase lock widget shared by all shop items
+	UPROPERTY(Transient)
+	FUserWidgetPool PurchaseWidgetPool;
+
+	UPROPERTY(Transient)
+	UPurchaseWidget* PurchaseWidget = nullptr;
+
+	TWeakObjectPtr<UWorld> PurchaseWidgetWorld;
+	int32 PurchaseWidgetShowCount = 0;
+	bool bPurchaseWidgetPrewarmed = false;
+
+	double LastPurchaseStartLatency = 0.0;
+	double TotalPurchaseStartLatency = 0.0;
+	int32 PurchaseStartsNum = 0;
+
+	float LastBillingConnectTime = 0.f;
+
+	// ProductID -> shop item data, built on init and filled in when data loaded later is resolved
+	TMap<FString, FStoreProductIndexEntry> ProductIndex;
+
+	// Products data assets were scanned for without match, not scanned again until they are indexed or index is rebuilt
+	mutable TSet<FString> MissingProductIds;
+
+	// Index changes are copied to purchase decoder once per frame
+	FTSTicker::FDelegateHandle ProductIndexPublishHandle;
 
 	// Interfaces
 	IOnlineSubsystem* OnlineSubsystem = nullptr;
@@ -76,39 +271,219 @@ protected:
 
 public:
 
+	// Not finalized purchases go through OnPurchaseComplete, owned finalized ones through OnPurchaseRestore
 	UFUNCTION(BlueprintCallable, Category = "Shop")
 	void RestorePurchases();
 
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsRestoreInProgress() const { return bRestoreInProgress; }
+
+	// Owned non-consumable, answered from entitlement cache
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsProductOwned(FString ProductId) const { return EntitlementCache && EntitlementCache->IsOwned(ProductId); }
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	TArray<FString> GetOwnedProducts() const;
+
+	// Restores purchases if entitlements were not reconciled within EntitlementReconcileInterval. Returns true if restore started
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	bool ReconcileEntitlementsIfStale();
+
 	UFUNCTION(BlueprintCallable, Category = "Shop")
 	void FinalizePurchase(FPurchaseReceiptInfo PurchaseReceiptInfo);
 
+	// All StoreProductIDs, queued for prefetch when bDemandDrivenProductFetch is on
 	UFUNCTION(BlueprintCallable, Category = "Shop")
 	void RequestAllProducts();
 
+	// Visible request of a prefetched product moves it ahead of prefetch queue
 	UFUNCTION(BlueprintCallable, Category = "Shop")
-	void RequestProductId(FString ProductId);
+	void RequestProductId(FString ProductId, EProductRequestPriority Priority = EProductRequestPriority::Visible);
+
+	// Drops visible request not sent yet, ignored while somebody is subscribed to product. Demand driven fetch
+	// moves product back to prefetch queue. Store queries already sent are still received into catalog
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void CancelProductRequest(FString ProductId);
+
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void CancelProductPrefetch();
+
+	// Visible requests not sent yet and whole prefetch queue
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void CancelProductRequests();
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	int32 GetPrefetchProductsNum() const { return PrefetchProductIdSet.Num(); }
 
 	UFUNCTION(BlueprintPure, Category = "Shop")
 	UPurchaseProxyInterface* GetPurchaseInterface() const {return PurchaseInterface;}
 
+	// Index lookup, data assets are scanned when index has no live entry
 	UFUNCTION(BlueprintPure, Category = "Shop")
 	UShopItemData* FindShopItemByProductId(FString ProductId) const;
 
+	// Same as FindShopItemByProductId, scanned result is added to index and published to purchase decoder
+	UShopItemData* ResolveShopItemByProductId(const FString& ProductId);
+
+	// Products without shop item data are consumed
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsProductConsumable(FString ProductId);
+
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void AddShopItemDataToIndex(UShopItemData* ShopItemData);
+
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void RemoveShopItemDataFromIndex(UShopItemData* ShopItemData);
+
+	void AddProductToIndex(const FString& ProductId, UShopItemData* ShopItemData, bool bIsConsumable);
+
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void RebuildProductIndex();
+
 	virtual void InitManager() override;
 
+	virtual void BeginDestroy() override;
+
 	void InitPlatformInterface();
 
+	// Replaces platform proxy, used by InitPlatformInterface and by benchmarks running against fake store
+	void SetPurchaseInterface(UPurchaseProxyInterface* InPurchaseInterface);
+
 	TSharedPtr<const FUniqueNetId> GetUniqueNetId() const { return UniqueNetId; }
 
+	// Offer view built on first request, prefer GetStoreCatalog for bulk reads
 	TSharedPtr<FOnlineStoreOffer> GetProduct(FString ProductId) const;
 
+	const FStoreCatalog& GetStoreCatalog() const { return StoreCatalog; }
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsProductFresh(FString ProductId) const { return StoreCatalog.IsFresh(ProductId); }
+
 	void StartPurchase(FString ProductID, bool Consumable);
 
+	// Returns request id, OnComplete is called once for this request only. OnPending may come before it
+	int32 StartPurchase(FString ProductID, bool Consumable, FPurchaseCompleteDelegate OnComplete, FPurchasePendingDelegate OnPending = FPurchasePendingDelegate());
+
+	// Unclaimed purchases of item product are handed to it right away
+	void RegisterShopItem(UShopItemMobileStorePurchase* ShopItem);
+	void UnregisterShopItem(const UShopItemMobileStorePurchase* ShopItem);
+
+	// Call after purchase content is applied and saved, before FinalizePurchase.
+	// Purchases without open request, like ones replayed from journal on start, are broadcast through OnPurchaseComplete
+	// and then granted by shop item of their product, unless listener marked them granted or finalized them
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void MarkPurchaseGranted(FString TransactionID);
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	EPurchaseTransactionState GetPurchaseRequestState(int32 RequestID) const;
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	EPurchaseTransactionState GetTransactionState(FString TransactionID) const;
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	int32 GetOpenPurchasesNum() const { return PurchaseTransactions.Num(); }
+
+	// Shows purchase lock widget, every call must be paired with HidePurchaseWidget
+	UFUNCTION(BlueprintCallable, Category = "Shop", meta = (WorldContext = "WorldContextObject"))
+	UPurchaseWidget* ShowPurchaseWidget(const UObject* WorldContextObject);
+
+	UFUNCTION(BlueprintCallable, Category = "Shop")
+	void HidePurchaseWidget();
+
+	UFUNCTION(BlueprintCallable, Category = "Shop", meta = (WorldContext = "WorldContextObject"))
+	void PrewarmPurchaseWidget(const UObject* WorldContextObject);
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsPurchaseWidgetShown() const { return PurchaseWidgetShowCount > 0; }
+
+	// Time from buy press to store purchase flow launch
+	void ReportPurchaseStartLatency(double Seconds);
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	float GetLastPurchaseStartLatency() const { return LastPurchaseStartLatency; }
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	float GetAveragePurchaseStartLatency() const { return PurchaseStartsNum > 0 ? TotalPurchaseStartLatency / PurchaseStartsNum : 0.f; }
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	EBillingConnectionState GetBillingConnectionState() const;
+
+	// Seconds last store connection took to become ready
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	float GetLastBillingConnectTime() const { return LastBillingConnectTime; }
+
 	void ReceiveProductInfo(TSharedPtr<FOnlineStoreOffer> ProductInfo);
+	void ReceiveProductsInfo(const TArray<TSharedPtr<FOnlineStoreOffer>>& ProductsInfo);
+	void ReceiveStoreProducts(const TArray<FStoreProduct>& Products);
+
+	// Wakes product subscribers and fires received events
+	void NotifyProductsUpdated(const TArray<FString>& ProductIDs);
 	void ProcessPurchase(FPurchaseInfoRaw PurchaseInfo);
-	void ProcessPurchaseError(FString Error);
+	void ProcessPurchaseError(FString ProductID, FString Error);
+	void ProcessFinalizeResults(const TArray<FPurchaseFinalizeResult>& Results);
+	void ProcessRestoredPurchases(const TArray<FPurchaseInfoRaw>& Purchases);
+	void ProcessPurchasesRestoreComplete(bool bSuccess, FString Error);
+	void ProcessConnectionStateChanged(EBillingConnectionState State, float ConnectSeconds);
+
+	UFUNCTION(BlueprintPure, Category = "Shop")
+	bool IsProductRequestInProgress(FString ProductId) const { return ScheduledProductIds.Contains(ProductId); }
 
 protected:
 
+	// Pool is bound to one world, it is reset when called from another one
+	bool SetPurchaseWidgetWorld(const UObject* WorldContextObject);
+
+	// Finalizes granted journal entries and replays not granted ones on next tick
+	void LoadPurchaseJournal();
+
+	void LoadProductCatalogCache();
+	void SaveProductCatalogCache();
+
+	bool FlushFinalizePurchases(float DeltaTime);
+
+	UShopItemData* ScanShopItemByProductId(const FString& ProductId) const;
+
+	void MarkProductIndexDirty();
+	bool PublishProductIndex(float DeltaTime);
+
+	void ScheduleProductsRequest();
+	bool FlushProductsRequest(float DeltaTime);
+
+	void SchedulePrefetch();
+	bool PrefetchProducts(float DeltaTime);
+
 	void RequestProducts();
+	void CompleteProductRequest(const FString& ProductId);
+	void ExpireProductRequestBatch(int32 BatchID);
+
+	// Stat and trace counters, called where product requests, purchases or catalog change
+	void UpdateStatCounters() const;
+
+	// Oldest launched request for product, most recent launched one if ProductID is empty
+	int32 FindLaunchedPurchaseRequest(const FString& ProductID) const;
+	void FailPurchaseRequest(int32 RequestID, const FString& Error);
+
+	// Play delivers not paid purchases with PurchaseState 2
+	static bool IsPendingPurchase(const FPurchaseInfoRaw& PurchaseInfo);
+	void ProcessPendingPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FPurchaseReceiptInfo& PurchaseReceiptInfo);
+
+	// Request waiting for payment of this transaction, or oldest launched one for product
+	int32 FindPurchaseRequest(const FPurchaseInfoRaw& PurchaseInfo);
+
+	// Purchase passed checks, it is journaled and handed to request callbacks
+	void AcceptPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FPurchaseReceiptInfo& PurchaseReceiptInfo);
+	void RejectPurchase(const FPurchaseInfoRaw& PurchaseInfo, const FString& Error);
+
+	void BroadcastRestoredPurchase(const FPurchaseInfoRaw& PurchaseInfo);
+
+	// Restored non-consumable is owned once purchase pipeline accepted it, or waits for its verification
+	void TrackRestoredOwnership(const FPurchaseInfoRaw& PurchaseInfo);
+	void ResolveRestoredOwnership(const FString& TransactionID, bool bOwned);
+	void ReconcileRestoredEntitlements();
+
+	// Purchase was granted by game code, its shop item must not grant it again
+	void RemoveUnclaimedPurchase(const FString& ProductID, const FString& TransactionID);
+
+	void LoadEntitlementCache();
+	void GrantEntitlement(const FString& ProductID, const FString& TransactionID);
 };
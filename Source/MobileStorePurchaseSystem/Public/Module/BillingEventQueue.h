@@ -0,0 +1,44 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+
+#include <atomic>
+
+// Lower value is drained first
+enum class EBillingEventPriority : uint8
+{
+	Purchase,
+	Catalog,
+	Num
+};
+
+// Store callbacks from any thread to game thread. Lock free for producers, drained once per frame within budget
+class MOBILESTOREPURCHASESYSTEM_API FBillingEventQueue
+{
+public:
+
+	~FBillingEventQueue();
+
+	void Start();
+	void Stop();
+
+	// Any thread
+	void Enqueue(EBillingEventPriority Priority, TUniqueFunction<void()>&& Event);
+
+	// Game thread. Runs at least one event, then stops when any budget is used up. Returns events run
+	int32 Drain(double TimeBudgetSeconds, int32 EventBudget);
+
+	int32 GetPendingNum() const { return PendingNum.load(std::memory_order_relaxed); }
+
+private:
+
+	bool Tick(float DeltaTime);
+
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Queues[static_cast<uint8>(EBillingEventPriority::Num)];
+	std::atomic<int32> PendingNum{0};
+
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,125 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+// Per event string logging, compiled out of shipping builds where the flight recorder keeps the history
+#if UE_BUILD_SHIPPING
+#define BILLING_LOG(...)
+#define BILLING_LOG_STATIC(...)
+#else
+#define BILLING_LOG(...) LOG(__VA_ARGS__)
+#define BILLING_LOG_STATIC(...) LOG_STATIC(__VA_ARGS__)
+#endif
+
+enum class EBillingFlightEvent : uint8
+{
+	None,
+	ProductsRequested,
+	ProductsReceived,
+	ProductsTimedOut,
+	PurchaseStarted,
+	PurchaseDelivered,
+	PurchasePending,
+	PurchaseAccepted,
+	PurchaseRejected,
+	PurchaseFailed,
+	PurchaseGranted,
+	FinalizeRequested,
+	FinalizeResult,
+	RestoreStarted,
+	RestoreComplete,
+	JniProductsCallback,
+	JniPurchaseCallback,
+	JniPurchaseErrorCallback,
+	JniFinalizeCallback,
+	JniRestoreCallback,
+	JniRestoreCompleteCallback,
+	BillingConnecting,
+	BillingConnected,
+	BillingDisconnected
+};
+
+struct FBillingFlightRecord
+{
+	uint64 Cycles = 0;
+	uint32 TransactionHandle = 0;
+	int32 Result = 0;
+	uint16 ProductHandle = 0;
+	EBillingFlightEvent Event = EBillingFlightEvent::None;
+};
+
+// Fixed size ring of binary billing events. Writers on any thread only bump an atomic index and fill a slot,
+// product ids are interned into a fixed lock free table and transactions are kept as 32 bit hashes
+class MOBILESTOREPURCHASESYSTEM_API FBillingFlightRecorder
+{
+public:
+
+	static FBillingFlightRecorder& Get();
+
+	FBillingFlightRecorder(const FBillingFlightRecorder&) = delete;
+	FBillingFlightRecorder& operator=(const FBillingFlightRecorder&) = delete;
+
+	// Any thread, lock free. Product id is hashed on every call, its name is copied only the first time it is seen
+	void Record(EBillingFlightEvent Event, const FString& ProductID = FString(), const FString& TransactionID = FString(), int32 Result = 0);
+
+	// Oldest first, slots being written at the moment are skipped
+	TArray<FBillingFlightRecord> Snapshot() const;
+
+	FString Dump() const;
+	void DumpToLog() const;
+
+	// Crash path, formats into stack buffer and writes to low level debug output without allocating or locking
+	void DumpOnCrash() const;
+
+	// Text is built on calling thread, file is written on a worker thread
+	void DumpToFile(const FString& Path) const;
+
+	// Honors bDumpFlightRecorderOnError
+	void DumpOnError() const;
+
+	static FString GetDumpPath();
+	static const TCHAR* GetEventName(EBillingFlightEvent Event);
+	static uint32 GetTransactionHandle(const FString& TransactionID);
+
+	void RegisterCrashHook();
+	void UnregisterCrashHook();
+
+private:
+
+	FBillingFlightRecorder();
+
+	struct FSlot
+	{
+		// Index + 1 of the record in slot, 0 while it is written
+		std::atomic<uint64> Sequence{0};
+		FBillingFlightRecord Record;
+	};
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask = 0;
+	std::atomic<uint64> WriteIndex{0};
+
+	static constexpr uint32 MaxProducts = 1024;
+	static constexpr int32 MaxProductIDLength = 64;
+
+	// Open addressing by product id hash, slot is claimed once and never released. Handle is slot index + 1, 0 is no product
+	struct FProductSlot
+	{
+		std::atomic<uint32> Hash{0};
+		std::atomic<bool> bNameReady{false};
+		TCHAR Name[MaxProductIDLength] = {};
+	};
+
+	TUniquePtr<FProductSlot[]> ProductSlots;
+
+	FDelegateHandle CrashHandle;
+
+	bool ReadRecord(uint64 Index, FBillingFlightRecord& OutRecord) const;
+
+	uint16 InternProduct(const FString& ProductID);
+	const TCHAR* GetProductName(uint16 ProductHandle) const;
+};
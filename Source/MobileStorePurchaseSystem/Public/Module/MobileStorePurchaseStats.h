@@ -0,0 +1,41 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// "stat MobileStorePurchase" in game, "-trace=cpu,counters,MobileStorePurchase" for Unreal Insights
+DECLARE_STATS_GROUP(TEXT("MobileStorePurchase"), STATGROUP_MobileStorePurchase, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(MobileStorePurchaseChannel, MOBILESTOREPURCHASESYSTEM_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RequestProducts"), STAT_MobileStorePurchase_RequestProducts, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ReceiveProducts"), STAT_MobileStorePurchase_ReceiveProducts, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("JNI Call"), STAT_MobileStorePurchase_JniCall, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("JNI Callback"), STAT_MobileStorePurchase_JniCallback, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Callback"), STAT_MobileStorePurchase_DecodeCallback, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Drain Billing Events"), STAT_MobileStorePurchase_DrainEvents, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ProcessPurchase"), STAT_MobileStorePurchase_ProcessPurchase, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FindShopItemByProductId"), STAT_MobileStorePurchase_FindShopItem, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FinalizePurchase"), STAT_MobileStorePurchase_FinalizePurchase, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Product Requests In Flight"), STAT_MobileStorePurchase_ProductRequests, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Purchases In Flight"), STAT_MobileStorePurchase_Purchases, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Cached Offers"), STAT_MobileStorePurchase_CachedOffers, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Queued Billing Events"), STAT_MobileStorePurchase_QueuedEvents, STATGROUP_MobileStorePurchase, MOBILESTOREPURCHASESYSTEM_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(MobileStorePurchase_ProductRequests);
+TRACE_DECLARE_INT_COUNTER_EXTERN(MobileStorePurchase_Purchases);
+TRACE_DECLARE_INT_COUNTER_EXTERN(MobileStorePurchase_CachedOffers);
+TRACE_DECLARE_INT_COUNTER_EXTERN(MobileStorePurchase_QueuedEvents);
+
+// Stat scope and trace event on module channel, Name is suffix of STAT_MobileStorePurchase_ stat
+#define MOBILE_STORE_PURCHASE_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_MobileStorePurchase_##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("MobileStorePurchase::" #Name, MobileStorePurchaseChannel)
+
+#define MOBILE_STORE_PURCHASE_COUNTER_SET(Name, Value) \
+	SET_DWORD_STAT(STAT_MobileStorePurchase_##Name, Value); \
+	TRACE_COUNTER_SET(MobileStorePurchase_##Name, Value)
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Module/BillingEventQueue.h"
 
 MOBILESTOREPURCHASESYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogMobileStorePurchaseSystem, All, Log);
 
@@ -13,13 +14,23 @@ class FMobileStorePurchaseSystemModule : public IModuleInterface
 private:
 
 	UAndroidBillingHelper* AndroidBillingHelper;
+
+	FBillingEventQueue BillingEventQueue;
 	
 public:
 
 	FMobileStorePurchaseSystemModule():AndroidBillingHelper(nullptr){}
 
+	static FMobileStorePurchaseSystemModule& Get()
+	{
+		return FModuleManager::GetModuleChecked<FMobileStorePurchaseSystemModule>("MobileStorePurchaseSystem");
+	}
+
 	UAndroidBillingHelper* GetAndroidBillingHelper() const { return AndroidBillingHelper; }
 
+	// Platform callbacks reach game thread only through this queue
+	FBillingEventQueue& GetBillingEventQueue() { return BillingEventQueue; }
+
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 	
@@ -22,6 +22,92 @@ public:
 	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase")
 	TMap<FString, TSoftClassPtr<UPurchaseProxyInterface>>PlatformsPurchaseInterfaceClasses;
 
+	// Product requests made within this time are sent as one batch. Zero means next frame
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 0, Units = "s"))
+	float ProductRequestCoalesceWindow = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 1))
+	int32 MaxProductRequestBatchSize = 100;
+
+	// Store query of a batch is split in shards of this size running in parallel, each shard is delivered as soon
+	// as it is answered. Zero queries whole batch at once
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 0))
+	int32 ProductQueryShardSize = 20;
+
+	// Products not answered by the store in this time can be requested again
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 1, Units = "s"))
+	float ProductRequestTimeout = 30.f;
+
+	// Only products of constructed shop items are requested right away, rest of StoreProductIDs is prefetched
+	// in small batches while no other product request is in flight
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests")
+	bool bDemandDrivenProductFetch = false;
+
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 1, EditCondition = "bDemandDrivenProductFetch"))
+	int32 ProductPrefetchBatchSize = 20;
+
+	// Idle check period of prefetch, first prefetch batch goes out after it
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Requests", meta = (ClampMin = 0, Units = "s", EditCondition = "bDemandDrivenProductFetch"))
+	float ProductPrefetchInterval = 1.f;
+
+	// Keep last received products on disk to show prices before store answers
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Cache")
+	bool bUseProductCatalogCache = true;
+
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Cache", meta = (ClampMin = 0, Units = "h", EditCondition = "bUseProductCatalogCache"))
+	float ProductCatalogCacheLifetime = 72.f;
+
+	// Cached products are shown, but can't be bought until store confirms them
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Cache", meta = (EditCondition = "bUseProductCatalogCache"))
+	bool bRequireFreshProductsForPurchase = true;
+
+	// Purchase widget stays shown at least this long, store flow is not delayed by it
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Purchase", meta = (ClampMin = 0, Units = "s"))
+	float MinPurchaseLockDuration = 0.f;
+
+	// Keep purchases on disk until they are finalized, unfinished ones are replayed on next start
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Purchase")
+	bool bUsePurchaseJournal = true;
+
+	// Create purchase widget on init so first purchase does not hitch
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Purchase")
+	bool bPrewarmPurchaseWidget = true;
+
+	// Owned non-consumables are kept on disk and answered without store
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Entitlements")
+	bool bUseEntitlementCache = true;
+
+	// Store restore runs on start only when cache was not reconciled for this long
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Entitlements", meta = (ClampMin = 0, Units = "h", EditCondition = "bUseEntitlementCache"))
+	float EntitlementReconcileInterval = 24.f;
+
+	// Check Google Play purchase signatures on a worker thread before content is granted
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Verification")
+	bool bVerifyPurchaseSignatures = false;
+
+	// Base64 RSA public key from Play Console, Monetize -> Monetization setup
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Verification", meta = (EditCondition = "bVerifyPurchaseSignatures"))
+	FString GooglePlayPublicKey;
+
+	// Game thread time per frame for store events, purchase events go before catalog ones
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Events", meta = (ClampMin = 0, Units = "ms"))
+	float BillingEventFrameBudget = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Events", meta = (ClampMin = 1))
+	int32 MaxBillingEventsPerFrame = 16;
+
+	// Pass Android products and purchases through JNI as JSON instead of plain field arrays. Slower, kept for comparison
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Android")
+	bool bUseJsonBillingTransfer = false;
+
+	// Billing events kept in memory, rounded up to power of two. Read once on first event
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Diagnostics", meta = (ClampMin = 64))
+	int32 FlightRecorderCapacity = 4096;
+
+	// Writes recorded events to Saved/MobileStorePurchase when a purchase fails or is rejected
+	UPROPERTY(EditDefaultsOnly, Config, Category = "MobileStorePurchase|Diagnostics")
+	bool bDumpFlightRecorderOnError = true;
+
 	// Debug
 	UPROPERTY(EditDefaultsOnly, Config, Category = "Debug")
 	bool bShowDebugMessages = false;
@@ -4,6 +4,7 @@
 
 #include "OnlineSubsystem.h"
 #include "Interfaces/OnlineStoreInterfaceV2.h"
+#include "Catalog/StoreCatalog.h"
 
 class UManagerMobileStorePurchase;
 
@@ -27,5 +28,5 @@ protected:
 	IOnlinePurchasePtr GetOnlinePurchase() const;
 	TArray<FString>& GetPendingProductIdRequests() const;
 	TArray<FString>& GetProductIdRequestsInProgress() const;
-	TMap<FString, TSharedPtr<FOnlineStoreOffer>>& GetStoreProducts() const;
+	FStoreCatalog& GetStoreCatalog() const;
 };
\ No newline at end of file
@@ -187,26 +187,31 @@ private:
 
 		if (!bWasSuccessful) return;
 
-		GetStoreProducts().Reserve(IOSReadObject->ProvidedProductInformation.Num());
+		TArray<FString> ReceivedProductIDs;
+		
+		FStoreCatalog& StoreCatalog = GetStoreCatalog();
+		StoreCatalog.Reserve(StoreCatalog.Num() + IOSReadObject->ProvidedProductInformation.Num());
 		for (const FInAppPurchaseProductInfo& Info : IOSReadObject->ProvidedProductInformation)
 		{
-			TSharedPtr<FOnlineStoreOffer> Offer = MakeShareable<FOnlineStoreOffer>(new FOnlineStoreOffer());
-			Offer->Description = FText::FromString(Info.DisplayDescription);
-			Offer->Title = FText::FromString(Info.DisplayName);
-			Offer->RegularPriceText = FText::FromString(Info.DisplayPrice);
-			Offer->RegularPrice = Info.RawPrice;
-			Offer->PriceText = FText::FromString(Info.DisplayPrice);
-			Offer->NumericPrice = Info.RawPrice;
-			Offer->CurrencyCode = Info.CurrencyCode;
+			FStoreProduct Product;
+			Product.ProductID = Info.Identifier;
+			Product.Title = Info.DisplayName;
+			Product.Description = Info.DisplayDescription;
+			Product.PriceText = Info.DisplayPrice;
+			Product.CurrencyCode = Info.CurrencyCode;
 
-			GetStoreProducts().Add(Info.Identifier, Offer);
+			// Raw price is in currency units, catalog keeps micros like Google Play
+			Product.MicrosPrice = FMath::RoundToInt64(static_cast<double>(Info.RawPrice) * 1000000.0);
+
+			StoreCatalog.Add(Product, true);
+			ReceivedProductIDs.Add(Info.Identifier);
 
 			UE_LOG(LogTemp, Log, TEXT("SKU: Receive product - %s"), *Info.Identifier);
 		}
 
 		GetProductIdRequestsInProgress().Empty();
 
-		Manager->OnProductsReceived.Broadcast();
+		Manager->NotifyProductsUpdated(ReceivedProductIDs);
 
 		RequestProducts();
 	}
@@ -223,28 +228,18 @@ private:
 		{
 			UE_LOG(LogTemp, Log, TEXT("SKU Purchase SUCCESS: %s"), *IOSPurchaseRequest->ProvidedProductInformation.Identifier);
 
-			FPurchaseReceiptInfo PurchaseReceipt;
-			PurchaseReceipt.ProductID = IOSPurchaseRequest->ProvidedProductInformation.Identifier;
-			PurchaseReceipt.TransactionID = IOSPurchaseRequest->ProvidedProductInformation.TransactionIdentifier;
-			PurchaseReceipt.ShopItemData = Manager->FindShopItemByProductId(PurchaseReceipt.ProductID);
-			PurchaseReceipt.CustomData.Add("ReceiptData", IOSPurchaseRequest->ProvidedProductInformation.ReceiptData);
+			FPurchaseInfoRaw PurchaseInfo;
+			PurchaseInfo.ProductID = IOSPurchaseRequest->ProvidedProductInformation.Identifier;
+			PurchaseInfo.TransactionID = IOSPurchaseRequest->ProvidedProductInformation.TransactionIdentifier;
+			PurchaseInfo.CustomData.Add("ReceiptData", IOSPurchaseRequest->ProvidedProductInformation.ReceiptData);
 			
-			Manager->OnPurchaseComplete.Broadcast(true, PurchaseReceipt);
+			Manager->ProcessPurchase(PurchaseInfo);
 		}
 		else
 		{
 			UE_LOG(LogTemp, Log, TEXT("SKU Purchase FAIL"));
 			
-			if(IOSPurchaseRequest)
-			{
-				UE_LOG(LogTemp, Log, TEXT("SKU Purchase fail broadcast with request"));
-				Manager->OnPurchaseComplete.Broadcast(false, FPurchaseReceiptInfo());
-			}
-			else
-			{
-				Manager->OnPurchaseComplete.Broadcast(
-					false, FPurchaseReceiptInfo());
-			}
+			Manager->ProcessPurchaseError(LastPurchaseProductRequest.ProductIdentifier, "IOS purchase failed");
 		}
 
 		IOSPurchaseRequest = nullptr;
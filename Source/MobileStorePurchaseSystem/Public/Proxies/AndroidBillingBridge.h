@@ -0,0 +1,95 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_ANDROID
+#include "Android/AndroidJNI.h"
+#endif
+
+enum class EAndroidBillingCall : uint8
+{
+	QueryProducts,
+	Purchase,
+	FinalizePurchase,
+	ProductsCallback,
+	PurchaseCallback,
+	PurchaseErrorCallback,
+	FinalizeCallback,
+	RestorePurchases,
+	RestoreCallback,
+	Num
+};
+
+struct FAndroidBillingCallStats
+{
+	int32 Calls = 0;
+	double TotalSeconds = 0.0;
+	double MaxSeconds = 0.0;
+	double LastSeconds = 0.0;
+
+	double GetAverageSeconds() const { return Calls > 0 ? TotalSeconds / Calls : 0.0; }
+};
+
+// Owns UnrealBillingAndroid class and method ids, resolved once on module startup, and native callbacks registration
+class MOBILESTOREPURCHASESYSTEM_API FAndroidBillingBridge
+{
+public:
+
+	static FAndroidBillingBridge& Get();
+
+	bool Initialize();
+	void Shutdown();
+
+	bool IsInitialized() const { return bInitialized; }
+
+	// Java side splits ids in shards of ShardSize queried in parallel, each shard answers separately. Zero is one query
+	void QueryProducts(const TArray<FString>& ProductIDs, bool bUseJsonTransfer, int32 ShardSize);
+	void Purchase(const FString& ProductID, bool bUseJsonTransfer);
+	void FinalizePurchase(const FString& PurchaseToken, bool bConsume);
+
+	// One JNI call for whole batch, Java side runs requests concurrently and answers once with all results
+	void FinalizePurchases(const TArray<FString>& PurchaseTokens, const TArray<bool>& Consume);
+
+	// Answer comes as many OnPurchasesRestored parts and one OnPurchasesRestoreComplete
+	void RestorePurchases();
+
+	// Asks Java side directly, helper keeps state reported by callbacks
+	int32 QueryConnectionState();
+	int64 QueryLastConnectMillis();
+
+	FAndroidBillingCallStats GetCallStats(EAndroidBillingCall Call) const;
+	void ResetCallStats();
+	
+	void RecordCall(EAndroidBillingCall Call, uint64 StartCycles);
+
+	// Measures time spent crossing JNI, in both directions
+	struct FScopedCallTimer
+	{
+		explicit FScopedCallTimer(EAndroidBillingCall InCall) : Call(InCall), StartCycles(FPlatformTime::Cycles64()) {}
+		~FScopedCallTimer() { FAndroidBillingBridge::Get().RecordCall(Call, StartCycles); }
+
+	private:
+
+		EAndroidBillingCall Call;
+		uint64 StartCycles;
+	};
+
+private:
+
+	bool bInitialized = false;
+
+	mutable FCriticalSection CallStatsLock;
+	FAndroidBillingCallStats CallStats[static_cast<uint8>(EAndroidBillingCall::Num)];
+
+#if PLATFORM_ANDROID
+	jclass BillingClass = nullptr;
+	jmethodID QueryProductsMethod = nullptr;
+	jmethodID PurchaseMethod = nullptr;
+	jmethodID FinalizePurchasesMethod = nullptr;
+	jmethodID RestorePurchasesMethod = nullptr;
+	jmethodID GetConnectionStateMethod = nullptr;
+	jmethodID GetLastConnectMillisMethod = nullptr;
+#endif
+};
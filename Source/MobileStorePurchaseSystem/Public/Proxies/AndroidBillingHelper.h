@@ -3,6 +3,7 @@
 #pragma once
 
 #include "UObject/Object.h"
+#include "Proxies/PurchaseProxyInterface.h"
 
 #include "AndroidBillingHelper.generated.h"
 
@@ -15,7 +16,7 @@ struct MOBILESTOREPURCHASESYSTEM_API FAndroidProductInfo
 	FString ProductID;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
-	int MicrosPrice;
+	int64 MicrosPrice = 0;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
 	FString FormattedPrice;
@@ -54,9 +55,28 @@ struct MOBILESTOREPURCHASESYSTEM_API FAndroidPurchaseInfo
 	TMap<FString, FString> Details;
 };
 
+USTRUCT(BlueprintType)
+struct MOBILESTOREPURCHASESYSTEM_API FAndroidFinalizeResult
+{
+	GENERATED_BODY()
+		
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
+	FString Token;
+
+	// Google Play BillingResponseCode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
+	int32 ResponseCode = 0;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAndroidProductQuery, const FAndroidProductInfo&, ProductInfo);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAndroidProductsQuery, const TArray<FAndroidProductInfo>&, ProductsInfo);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAndroidPurchase, FAndroidPurchaseInfo, PurchaseInfo);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAndroidPurchaseFail, FString, ProductID, FString, Error);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAndroidPurchasesFinalize, const TArray<FAndroidFinalizeResult>&, Results);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAndroidPurchasesRestoreComplete, bool, bSuccess, FString, Error);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnAndroidConnectionStateChanged, EBillingConnectionState, State, int32, ResponseCode, float, ConnectSeconds);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnAndroidPurchaseDecoded, const FPurchaseInfoRaw& PurchaseInfo);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnAndroidPurchasesRestoreDecoded, const TArray<FPurchaseInfoRaw>& Purchases);
 
 UCLASS()
 class MOBILESTOREPURCHASESYSTEM_API UAndroidBillingHelper : public UObject
@@ -68,12 +88,33 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnAndroidProductQuery OnProductInfoReceive;
 
+	// Whole query result, delivered once per store answer
+	UPROPERTY(BlueprintAssignable)
+	FOnAndroidProductsQuery OnProductsInfoReceive;
+
 	UPROPERTY(BlueprintAssignable)
 	FOnAndroidPurchase OnPurchaseSuccess;
 
+	// Same purchase as OnPurchaseSuccess, already normalized and resolved on worker thread
+	FOnAndroidPurchaseDecoded OnPurchaseDecoded;
+
 	UPROPERTY(BlueprintAssignable)
 	FOnAndroidPurchaseFail OnPurchaseFail;
 
+	// One call per FinalizePurchases batch
+	UPROPERTY(BlueprintAssignable)
+	FOnAndroidPurchasesFinalize OnPurchasesFinalize;
+
+	// Part of RestorePurchases answer, decoded on worker thread
+	FOnAndroidPurchasesRestoreDecoded OnPurchasesRestoreDecoded;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnAndroidPurchasesRestoreComplete OnPurchasesRestoreComplete;
+
+	// Java side reconnects with backoff by itself and runs queued calls once connected
+	UPROPERTY(BlueprintAssignable)
+	FOnAndroidConnectionStateChanged OnConnectionStateChanged;
+
 public:
 
 	UFUNCTION(BlueprintPure, Category="Billing")
@@ -87,4 +128,27 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category="Billing")
 	void FinalizePurchase(FAndroidPurchaseInfo PurchaseInfo, bool Consume);
+
+	// In-app and subscription purchases owned by user, results are streamed as each store query answers
+	UFUNCTION(BlueprintCallable, Category="Billing")
+	void RestorePurchases();
+
+	// Consume and acknowledge many purchases in one JNI call, Consume has flag for every purchase
+	UFUNCTION(BlueprintCallable, Category="Billing")
+	void FinalizePurchases(const TArray<FAndroidPurchaseInfo>& PurchasesInfo, const TArray<bool>& Consume);
+
+	UFUNCTION(BlueprintPure, Category="Billing")
+	EBillingConnectionState GetConnectionState() const { return ConnectionState; }
+
+	// Seconds last successful connection took
+	UFUNCTION(BlueprintPure, Category="Billing")
+	float GetLastConnectTime() const { return LastConnectSeconds; }
+
+	// Game thread, called by billing bridge
+	void SetConnectionState(EBillingConnectionState State, int32 ResponseCode, float ConnectSeconds);
+
+private:
+
+	EBillingConnectionState ConnectionState = EBillingConnectionState::Disconnected;
+	float LastConnectSeconds = 0.f;
 };
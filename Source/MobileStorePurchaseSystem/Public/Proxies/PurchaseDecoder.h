@@ -0,0 +1,33 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Proxies/PurchaseProxyInterface.h"
+
+class UShopItemData;
+struct FAndroidPurchaseInfo;
+
+// Builds FPurchaseInfoRaw from store payloads on task workers, game thread only gets ready purchases
+class MOBILESTOREPURCHASESYSTEM_API FPurchaseDecoder
+{
+public:
+
+	static FPurchaseDecoder& Get();
+
+	// Game thread. Manager publishes new copy of its index after changes
+	void SetProductIndex(TMap<FString, TWeakObjectPtr<UShopItemData>>&& InProductIndex);
+
+	// Any thread. Weak pointer is only dereferenced on game thread
+	TWeakObjectPtr<UShopItemData> FindShopItem(const FString& ProductID) const;
+
+	// Any thread. Flattens Android fields to custom data and resolves shop item
+	FPurchaseInfoRaw MakePurchaseInfo(const FAndroidPurchaseInfo& AndroidPurchaseInfo) const;
+
+	// Any thread. Google Play purchase JSON to Android purchase, original JSON is kept for signature check
+	static bool ParseGooglePlayPurchase(const FString& PurchaseJson, const FString& Signature, FAndroidPurchaseInfo& OutPurchaseInfo);
+
+private:
+
+	mutable FCriticalSection ProductIndexLock;
+	TSharedPtr<const TMap<FString, TWeakObjectPtr<UShopItemData>>, ESPMode::ThreadSafe> ProductIndex;
+};
@@ -5,9 +5,21 @@
 #include "UObject/Object.h"
 
 #include "Interfaces/OnlineStoreInterfaceV2.h"
+#include "Catalog/StoreCatalog.h"
 
 #include "PurchaseProxyInterface.generated.h"
 
+class UShopItemData;
+
+// Same values as connection states of UnrealBillingAndroid
+UENUM(BlueprintType)
+enum class EBillingConnectionState : uint8
+{
+	Disconnected,
+	Connecting,
+	Connected
+};
+
 USTRUCT(BlueprintType)
 struct MOBILESTOREPURCHASESYSTEM_API FPurchaseInfoRaw
 {
@@ -21,11 +33,38 @@ struct MOBILESTOREPURCHASESYSTEM_API FPurchaseInfoRaw
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
 	TMap<FString, FString> CustomData;
+
+	// Set when proxy resolved it while decoding, manager looks it up otherwise
+	UPROPERTY()
+	TWeakObjectPtr<UShopItemData> ShopItemData;
+};
+
+USTRUCT(BlueprintType)
+struct MOBILESTOREPURCHASESYSTEM_API FPurchaseFinalizeResult
+{
+	GENERATED_BODY()
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
+	FString TransactionID;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
+	bool bSuccess = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Billing")
+	FString Error;
 };
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FProductReceiveEvent, TSharedPtr<FOnlineStoreOffer> ProductInfo);
+DECLARE_MULTICAST_DELEGATE_OneParam(FProductsReceiveEvent, const TArray<FStoreProduct>& Products);
 DECLARE_MULTICAST_DELEGATE_OneParam(FProductPurchaseEvent, FPurchaseInfoRaw PurchaseInfo);
-DECLARE_MULTICAST_DELEGATE_OneParam(FProductPurchaseErrorEvent, FString Error);
+// ProductID is empty when store does not report which purchase failed
+DECLARE_MULTICAST_DELEGATE_TwoParams(FProductPurchaseErrorEvent, FString ProductID, FString Error);
+DECLARE_MULTICAST_DELEGATE_OneParam(FPurchasesFinalizeEvent, const TArray<FPurchaseFinalizeResult>& Results);
+// Part of restore answer, called many times per restore
+DECLARE_MULTICAST_DELEGATE_OneParam(FPurchasesRestoreEvent, const TArray<FPurchaseInfoRaw>& Purchases);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FPurchasesRestoreCompleteEvent, bool bSuccess, FString Error);
+// ConnectSeconds is time from connection start to ready, zero for other states
+DECLARE_MULTICAST_DELEGATE_TwoParams(FConnectionStateChangeEvent, EBillingConnectionState State, float ConnectSeconds);
 
 UCLASS(Abstract)
 class MOBILESTOREPURCHASESYSTEM_API UPurchaseProxyInterface : public UObject
@@ -38,18 +77,59 @@ public:
 
 public:
 
+	// Single product delivery, prefer OnProductsReceive for store answers with many products
 	FProductReceiveEvent OnProductReceive;
+
+	FProductsReceiveEvent OnProductsReceive;
 	
 	FProductPurchaseEvent OnProductPurchased;
 
 	FProductPurchaseErrorEvent OnProductPurchaseError;
 
+	// One call per FinalizePurchases batch, with result for every purchase in it
+	FPurchasesFinalizeEvent OnPurchasesFinalized;
+
+	// Owned purchases streamed in parts while store answers
+	FPurchasesRestoreEvent OnPurchasesRestored;
+
+	// Called once after last part
+	FPurchasesRestoreCompleteEvent OnPurchasesRestoreComplete;
+
+	FConnectionStateChangeEvent OnConnectionStateChanged;
+
+	// Stores without service connection are always ready. Calls made while not connected are queued by platform
+	virtual EBillingConnectionState GetConnectionState() const { return EBillingConnectionState::Connected; }
+
 	// Start purchase process
 	virtual void Purchase(FString ProductID){};
 
+	// Query purchases owned by user, including not finalized ones
+	virtual void RestorePurchases()
+	{
+		OnPurchasesRestoreComplete.Broadcast(false, "Restore is not supported");
+	};
+
 	// Tell platform that we received a product. Place custom information into CustomData if necessary
 	virtual void FinalizePurchase(const FPurchaseInfoRaw& PurchaseInfo){};
 
+	// Finalize many purchases at once. Platforms without finalize results report every purchase as successful
+	virtual void FinalizePurchases(const TArray<FPurchaseInfoRaw>& Purchases)
+	{
+		TArray<FPurchaseFinalizeResult> Results;
+		Results.Reserve(Purchases.Num());
+		
+		for(const FPurchaseInfoRaw& PurchaseInfo : Purchases)
+		{
+			FinalizePurchase(PurchaseInfo);
+
+			FPurchaseFinalizeResult& Result = Results.AddDefaulted_GetRef();
+			Result.TransactionID = PurchaseInfo.TransactionID;
+			Result.bSuccess = true;
+		}
+
+		OnPurchasesFinalized.Broadcast(Results);
+	};
+
 	// Request products info
 	virtual void RequestProducts(TArray<FString> ProductsID){};
 
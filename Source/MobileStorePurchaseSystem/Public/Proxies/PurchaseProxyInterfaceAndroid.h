@@ -14,6 +14,8 @@ class MOBILESTOREPURCHASESYSTEM_API UPurchaseProxyInterfaceAndroid : public UPur
 	GENERATED_BODY()
 
 public:
+
+	virtual void PostInitProperties() override;
 	
 	virtual void Purchase(FString ProductID) override;
 	
@@ -21,12 +23,28 @@ public:
 
 	virtual void FinalizePurchase(const FPurchaseInfoRaw& PurchaseInfo) override;
 
-	UFUNCTION()
-	void ProcessPurchase(FAndroidPurchaseInfo PurchaseInfo);
+	virtual void FinalizePurchases(const TArray<FPurchaseInfoRaw>& Purchases) override;
+
+	virtual void RestorePurchases() override;
+
+	virtual EBillingConnectionState GetConnectionState() const override;
+
+	void ProcessPurchase(const FPurchaseInfoRaw& PurchaseInfo);
 	
 	UFUNCTION()
 	void ProcessPurchaseFail(FString PurchaseID, FString Error);
 	
+	void ProcessPurchasesRestore(const TArray<FPurchaseInfoRaw>& Purchases);
+
+	UFUNCTION()
+	void ProcessPurchasesRestoreComplete(bool bSuccess, FString Error);
+	
+	UFUNCTION()
+	void ProcessPurchasesFinalize(const TArray<FAndroidFinalizeResult>& Results);
+	
+	UFUNCTION()
+	void ReceiveProducts(const TArray<FAndroidProductInfo>& ProductsInfo);
+
 	UFUNCTION()
-	void ReceiveProduct(const FAndroidProductInfo& ProductInfo);
+	void ProcessConnectionStateChanged(EBillingConnectionState State, int32 ResponseCode, float ConnectSeconds);
 };
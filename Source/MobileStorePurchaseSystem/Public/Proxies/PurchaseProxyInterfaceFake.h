@@ -0,0 +1,135 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Proxies/PurchaseProxyInterface.h"
+
+#include "Containers/Ticker.h"
+
+#include "PurchaseProxyInterfaceFake.generated.h"
+
+USTRUCT(BlueprintType)
+struct MOBILESTOREPURCHASESYSTEM_API FFakeStoreLatency
+{
+	GENERATED_BODY()
+
+	FFakeStoreLatency() {}
+	FFakeStoreLatency(float InMinSeconds, float InMaxSeconds) : MinSeconds(InMinSeconds), MaxSeconds(InMaxSeconds) {}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FakeStore", meta = (ClampMin = 0, Units = "s"))
+	float MinSeconds = 0.05f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FakeStore", meta = (ClampMin = 0, Units = "s"))
+	float MaxSeconds = 0.3f;
+};
+
+// In-process store for running full purchase pipeline off device. Select it in PlatformsPurchaseInterfaceClasses
+UCLASS(Config=Game)
+class MOBILESTOREPURCHASESYSTEM_API UPurchaseProxyInterfaceFake : public UPurchaseProxyInterface
+{
+	GENERATED_BODY()
+
+public:
+
+	// Generated products in addition to StoreProductIDs from settings
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Catalog", meta = (ClampMin = 0))
+	int32 CatalogSize = 100;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Catalog")
+	FString GeneratedProductPrefix = "fake_product_";
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Catalog")
+	FString CurrencyCode = "USD";
+
+	// Also used for every restore part
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Latency")
+	FFakeStoreLatency QueryLatency;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Latency")
+	FFakeStoreLatency PurchaseLatency;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Latency")
+	FFakeStoreLatency FinalizeLatency;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures", meta = (ClampMin = 0, ClampMax = 1))
+	float QueryErrorRate = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures", meta = (ClampMin = 0, ClampMax = 1))
+	float PurchaseErrorRate = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures", meta = (ClampMin = 0, ClampMax = 1))
+	float FinalizeErrorRate = 0.f;
+
+	// Chance to deliver same callback twice
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures", meta = (ClampMin = 0, ClampMax = 1))
+	float DuplicateCallbackRate = 0.f;
+
+	// Query answers are split into shuffled parts delivered with separate latencies
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures")
+	bool bOutOfOrderCallbacks = false;
+
+	// Chance for purchase to be delivered as pending first and as purchased after PendingPurchaseLatency
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures", meta = (ClampMin = 0, ClampMax = 1))
+	float PendingPurchaseRate = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Failures")
+	FFakeStoreLatency PendingPurchaseLatency = FFakeStoreLatency(5.f, 15.f);
+
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore|Catalog", meta = (ClampMin = 1))
+	int32 RestorePartSize = 20;
+
+	// Zero uses random seed
+	UPROPERTY(EditDefaultsOnly, Config, BlueprintReadWrite, Category = "FakeStore")
+	int32 RandomSeed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FakeStore|Stats")
+	int32 QueriesCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FakeStore|Stats")
+	int32 PurchasesCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FakeStore|Stats")
+	int32 FinalizedCount = 0;
+
+public:
+
+	virtual void PostInitProperties() override;
+
+	virtual void Purchase(FString ProductID) override;
+
+	virtual void RequestProducts(TArray<FString> ProductsID) override;
+
+	virtual void FinalizePurchase(const FPurchaseInfoRaw& PurchaseInfo) override;
+
+	virtual void FinalizePurchases(const TArray<FPurchaseInfoRaw>& Purchases) override;
+
+	// Streams purchases that were not consumed
+	virtual void RestorePurchases() override;
+
+	// Drops generated catalog, next request builds it from current properties
+	UFUNCTION(BlueprintCallable, Category = "FakeStore")
+	void ResetCatalog();
+
+	UFUNCTION(BlueprintPure, Category = "FakeStore")
+	FString GetGeneratedProductID(int32 Index) const;
+
+	bool IsPurchaseFinalized(const FString& TransactionID) const { return FinalizedTransactions.Contains(TransactionID); }
+
+private:
+
+	TMap<FString, FStoreProduct> Catalog;
+	TSet<FString> FinalizedTransactions;
+
+	// Delivered purchases until consumed
+	TMap<FString, FPurchaseInfoRaw> OwnedPurchases;
+
+	FRandomStream Random;
+
+	void BuildCatalog();
+
+	float RollLatency(const FFakeStoreLatency& Latency);
+	bool Roll(float Rate);
+
+	void Schedule(float Delay, TFunction<void()>&& Callback);
+	void ScheduleWithDuplicates(float Delay, const TFunction<void()>& Callback);
+};
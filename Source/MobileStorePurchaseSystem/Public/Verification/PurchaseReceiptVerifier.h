@@ -0,0 +1,37 @@
+// Copyright shenkns Mobile Store Purchase System Developed With Unreal Engine. All Rights Reserved 2023.
+
+#pragma once
+
+#include "Proxies/PurchaseProxyInterface.h"
+
+DECLARE_DELEGATE_TwoParams(FPurchaseVerifyDelegate, bool bValid, const FString& Error);
+
+// Local check of store purchase signatures. Crypto runs on thread pool, results come back on game thread
+class MOBILESTOREPURCHASESYSTEM_API FPurchaseReceiptVerifier
+{
+public:
+
+	// Base64 X.509 RSA public key, as shown in Play Console
+	explicit FPurchaseReceiptVerifier(const FString& GooglePlayPublicKey);
+
+	bool IsKeyValid() const;
+
+	// Purchases with Google Play original JSON in custom data are verified, other stores are passed through
+	static bool NeedsVerification(const FPurchaseInfoRaw& PurchaseInfo);
+
+	// Already verified tokens are answered right away without crypto
+	void Verify(const FPurchaseInfoRaw& PurchaseInfo, FPurchaseVerifyDelegate OnComplete);
+
+	bool IsVerified(const FPurchaseInfoRaw& PurchaseInfo) const;
+
+	// SHA1withRSA check used by Google Play, thread safe. Works on any platform with locally generated keys
+	static bool VerifyGooglePlaySignature(const FString& PublicKeyBase64, const FString& SignedData, const FString& SignatureBase64);
+
+	// Signed JSON must describe the same purchase as delivered fields
+	static bool MatchesPurchase(const FString& SignedData, const FString& ProductID, const FString& TransactionID);
+
+private:
+
+	struct FState;
+	TSharedRef<FState, ESPMode::ThreadSafe> State;
+};